@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../Common/NodePool.h"
+#include "../Common/TraceRecord.h"
+
+// Adaptive Replacement Cache (Megiddo & Modha, FAST '03).
+//
+// T1/T2 hold cached keys seen once/at least twice recently, and the ghost
+// lists B1/B2 remember keys recently evicted from them. The directory obeys
+// |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c, so all four lists
+// share one pool of 2c nodes and every access is O(1). Pool is NodePool for
+// raw offsets or DenseNodePool for dense key ids (see DenseKeys.h).
+template <class Pool>
+class BasicARCCache {
+private:
+    enum ListId : uint8_t { IN_T1, IN_T2, IN_B1, IN_B2 };
+
+    size_t capacity;
+    size_t p = 0; // Adaptive parameter: target size of T1
+
+    Pool pool;
+    std::vector<uint8_t> list_of;   // Which list each node is on
+
+    NodeList T1; // Recently accessed items
+    NodeList T2; // Frequently accessed items
+    NodeList B1; // Evicted from T1
+    NodeList B2; // Evicted from T2
+
+    NodeList& listFor(uint8_t id) {
+        switch (id) {
+            case IN_T1: return T1;
+            case IN_T2: return T2;
+            case IN_B1: return B1;
+            default: return B2;
+        }
+    }
+
+    void moveTo(uint32_t node, uint8_t target) {
+        pool.unlink(listFor(list_of[node]), node);
+        pool.pushFront(listFor(target), node);
+        list_of[node] = target;
+    }
+
+    // Drop the least recently used key of a list from the directory
+    void discardLast(NodeList& list) {
+        uint32_t node = list.tail;
+        pool.unlink(list, node);
+        pool.erase(node);
+    }
+
+    // Demote the LRU page of T1 or T2 to its ghost list
+    void replace(bool in_b2) {
+        if (T1.size > 0 && (T2.size == 0 || T1.size > p || (in_b2 && T1.size == p))) {
+            moveTo(T1.tail, IN_B1);
+        } else {
+            moveTo(T2.tail, IN_B2);
+        }
+    }
+
+public:
+    // key_count is the number of dense ids for DenseNodePool
+    explicit BasicARCCache(size_t cap, size_t key_count = 0)
+        : capacity(std::min<size_t>(cap, NO_NODE / 2 - 1)), pool(2 * capacity, key_count),
+          list_of(2 * capacity) {}
+
+    static const char* name() { return "ARC"; }
+
+    // Hint that the key is about to be accessed
+    void prefetch(long long key) const { pool.prefetch(key); }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("p", static_cast<long long>(p));
+        report("t1", static_cast<long long>(T1.size));
+        report("t2", static_cast<long long>(T2.size));
+        report("b1", static_cast<long long>(B1.size));
+        report("b2", static_cast<long long>(B2.size));
+    }
+
+    // Capacity, p and the four lists (see Snapshot.h)
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(capacity);
+        out.putU64(p);
+        pool.saveList(out, T1);
+        pool.saveList(out, T2);
+        pool.saveList(out, B1);
+        pool.saveList(out, B2);
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t saved_capacity;
+        if (!in.getSize(saved_capacity, capacity) || saved_capacity != capacity) return false;
+        if (!in.getSize(p, capacity)) return false;
+        for (uint8_t id : {IN_T1, IN_T2, IN_B1, IN_B2}) {
+            NodeList& list = listFor(id);
+            if (!pool.loadList(in, list, capacity)) return false;
+            for (uint32_t node = list.head; node != NO_NODE; node = pool.next(node)) list_of[node] = id;
+        }
+        return T1.size + T2.size <= capacity && T1.size + B1.size <= capacity;
+    }
+
+    // Access an item in the cache; returns true on a hit
+    bool access(long long key, OpType) {
+        if (capacity == 0) return false;
+
+        uint32_t node = pool.find(key);
+        if (node != NO_NODE) {
+            switch (list_of[node]) {
+                case IN_T1:
+                case IN_T2:
+                    // Hit: move to the MRU position of T2
+                    moveTo(node, IN_T2);
+                    return true;
+                case IN_B1:
+                    // Ghost hit in B1: grow T1's target
+                    p = std::min(p + std::max<size_t>(1, B2.size / B1.size), capacity);
+                    replace(false);
+                    moveTo(node, IN_T2);
+                    return false;
+                default: {
+                    // Ghost hit in B2: shrink T1's target
+                    size_t delta = std::max<size_t>(1, B1.size / B2.size);
+                    p = p > delta ? p - delta : 0;
+                    replace(true);
+                    moveTo(node, IN_T2);
+                    return false;
+                }
+            }
+        }
+
+        // Miss in every list: make room in the directory, then add to T1
+        if (T1.size + B1.size == capacity) {
+            if (T1.size < capacity) {
+                discardLast(B1);
+                replace(false);
+            } else {
+                discardLast(T1);
+            }
+        } else if (T1.size + T2.size + B1.size + B2.size >= capacity) {
+            if (T1.size + T2.size + B1.size + B2.size == 2 * capacity) discardLast(B2);
+            replace(false);
+        }
+
+        node = pool.insert(key);
+        pool.pushFront(T1, node);
+        list_of[node] = IN_T1;
+        return false;
+    }
+};
+
+using ARC_Cache = BasicARCCache<NodePool>;
+using DenseARC_Cache = BasicARCCache<DenseNodePool>;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "../Common/NodePool.h"
+#include "../Common/TraceRecord.h"
+
+// Lazy ARC: a new offset is cached and also remembered in a ghost list of
+// half the cache size, and a ghost hit reinstates an evicted offset. Both
+// lists are LRU-ordered lists of pool nodes with their own index, since an
+// offset may be on both at once. Pool is NodePool for raw offsets or
+// DenseNodePool for dense key ids (see DenseKeys.h).
+template <class Pool>
+class BasicLARCCache {
+private:
+    size_t capacity;
+    size_t ghost_capacity;
+    Pool cache_pool;
+    Pool ghost_pool;
+    NodeList cache;
+    NodeList ghost_cache;
+
+    // Evict the least recently used offset if the cache is full
+    void replace() {
+        if (cache.size >= capacity) {
+            uint32_t evicted = cache.tail;
+            cache_pool.unlink(cache, evicted);
+            cache_pool.erase(evicted);
+        }
+    }
+
+    void insert(long long key) { cache_pool.pushFront(cache, cache_pool.insert(key)); }
+
+public:
+    // key_count is the number of dense ids for DenseNodePool
+    explicit BasicLARCCache(size_t cap, size_t key_count = 0)
+        : capacity(std::min<size_t>(cap, NO_NODE - 2)), ghost_capacity(capacity / 2),
+          cache_pool(capacity, key_count), ghost_pool(ghost_capacity + 1, key_count) {}
+
+    static const char* name() { return "LARC"; }
+
+    // Hint that the key is about to be accessed
+    void prefetch(long long key) const { cache_pool.prefetch(key); }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("cached", static_cast<long long>(cache.size));
+        report("ghost", static_cast<long long>(ghost_cache.size));
+    }
+
+    // Capacity, the cache list and the ghost list (see Snapshot.h)
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(capacity);
+        cache_pool.saveList(out, cache);
+        ghost_pool.saveList(out, ghost_cache);
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t saved_capacity;
+        if (!in.getSize(saved_capacity, capacity) || saved_capacity != capacity) return false;
+        return cache_pool.loadList(in, cache, capacity) && ghost_pool.loadList(in, ghost_cache, ghost_capacity);
+    }
+
+    // Access an item in the cache; returns true on a hit
+    bool access(long long key, OpType) {
+        if (capacity == 0) return false;
+
+        uint32_t node = cache_pool.find(key);
+        if (node != NO_NODE) {
+            cache_pool.moveToFront(cache, node);
+            return true;
+        }
+
+        uint32_t ghost = ghost_pool.find(key);
+        if (ghost != NO_NODE) {
+            ghost_pool.unlink(ghost_cache, ghost);
+            ghost_pool.erase(ghost);
+            replace();
+            insert(key);
+        } else {
+            replace();
+            insert(key);
+            ghost_pool.pushFront(ghost_cache, ghost_pool.insert(key));
+            if (ghost_cache.size > ghost_capacity) {
+                uint32_t old = ghost_cache.tail;
+                ghost_pool.unlink(ghost_cache, old);
+                ghost_pool.erase(old);
+            }
+        }
+        return false;
+    }
+};
+
+using LARC_Cache = BasicLARCCache<NodePool>;
+using DenseLARC_Cache = BasicLARCCache<DenseNodePool>;
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../Arc/ARC_Cache.h"
+#include "../Arc/LARC_Cache.h"
+#include "../LRU/LRU_Cache.h"
+#include "../N-hit/NHitCache.h"
+#include "../Oracle/BeladyCache.h"
+#include "../Common/BinaryTrace.h"
+#include "../Common/DenseKeys.h"
+#include "../Common/TraceReader.h"
+#include "../Common/Workload.h"
+
+// Microbenchmarks for the policy cores and the trace parsers.
+//
+// Every policy runs over the same seeded Zipf request streams at several
+// cache sizes. Each case is repeated and the median time is reported, along
+// with heap allocations per access and the peak heap the case needed, both
+// counted by the replacement operator new below. The parser section writes a
+// seeded CSV trace, converts it to binary and times TraceReader over both.
+// Usage: Benchmark [--quick] [--csv results.csv]
+
+// ---- Allocation counting ---------------------------------------------------
+
+namespace alloc_count {
+
+// Each block carries its size in a 16-byte header, which keeps malloc's alignment
+const size_t HEADER = 16;
+
+long long allocations = 0;
+long long live_bytes = 0;
+long long peak_bytes = 0;
+
+inline void* allocate(size_t size) {
+    void* block = std::malloc(size + HEADER);
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    allocations++;
+    live_bytes += static_cast<long long>(size);
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+    return static_cast<char*>(block) + HEADER;
+}
+
+inline void release(void* pointer) {
+    if (pointer == nullptr) return;
+    void* block = static_cast<char*>(pointer) - HEADER;
+    live_bytes -= static_cast<long long>(*static_cast<size_t*>(block));
+    std::free(block);
+}
+
+} // namespace alloc_count
+
+void* operator new(size_t size) { return alloc_count::allocate(size); }
+void* operator new[](size_t size) { return alloc_count::allocate(size); }
+void operator delete(void* pointer) noexcept { alloc_count::release(pointer); }
+void operator delete[](void* pointer) noexcept { alloc_count::release(pointer); }
+void operator delete(void* pointer, size_t) noexcept { alloc_count::release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { alloc_count::release(pointer); }
+
+// ---- Helpers ----------------------------------------------------------------
+
+// Peak resident set size of the process in MB
+double peakRssMb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// Seeded Zipf(skew) stream over `keys` page-aligned offsets, 70% reads
+std::vector<TraceRecord> zipfRequests(size_t count, size_t keys, double skew, unsigned seed) {
+    WorkloadSpec spec;
+    spec.requests = static_cast<long long>(count);
+    spec.keys = static_cast<long long>(keys);
+    spec.skew = skew;
+    spec.response_time = 100;
+    spec.seed = seed;
+    WorkloadGenerator generator(spec);
+    std::vector<TraceRecord> requests(count);
+    for (TraceRecord& record : requests) generator.next(record);
+    return requests;
+}
+
+// The same stream with every offset replaced by its dense id (see DenseKeys.h);
+// distinct is the number of ids
+std::vector<TraceRecord> denseRequests(const std::vector<TraceRecord>& requests, size_t& distinct) {
+    TraceColumns columns;
+    columns.reserve(requests.size());
+    for (const TraceRecord& record : requests) columns.push_back(record);
+    assignDenseKeys(columns, distinct);
+
+    std::vector<TraceRecord> dense(requests);
+    for (size_t i = 0; i < dense.size(); i++) dense[i].offset = columns.keys[i];
+    return dense;
+}
+
+struct CaseResult {
+    double ns_per_access = 0;
+    double allocations_per_access = 0;
+    double peak_heap_mb = 0;
+    double hit_rate = 0;
+};
+
+// Run a fresh policy from `make` over the requests `repetitions` times;
+// the median time is reported
+template <class MakePolicy>
+CaseResult runCase(MakePolicy make, const std::vector<TraceRecord>& requests, int repetitions) {
+    std::vector<double> times;
+    CaseResult result;
+    for (int r = 0; r < repetitions; r++) {
+        long long live_before = alloc_count::live_bytes;
+        alloc_count::peak_bytes = live_before;
+        auto policy = make();
+
+        long long allocations_before = alloc_count::allocations;
+        long long hits = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (const TraceRecord& record : requests) hits += policy->access(record.offset, record.type);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        times.push_back(seconds * 1e9 / requests.size());
+        result.allocations_per_access = static_cast<double>(alloc_count::allocations - allocations_before) / requests.size();
+        result.peak_heap_mb = (alloc_count::peak_bytes - live_before) / (1024.0 * 1024.0);
+        result.hit_rate = 100.0 * hits / requests.size();
+    }
+    std::sort(times.begin(), times.end());
+    result.ns_per_access = times[times.size() / 2];
+    return result;
+}
+
+struct Workload {
+    std::string name;
+    double skew;
+};
+
+// ---- Main -------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    bool quick = false;
+    std::string csv_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--csv results.csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    const size_t request_count = quick ? 200000 : 2000000;
+    const size_t key_count = quick ? 100000 : 500000;
+    const int repetitions = quick ? 1 : 5;
+    const std::vector<size_t> cache_sizes = {1000, 10000, 100000};
+    const std::vector<Workload> workloads = {{"zipf0.6", 0.6}, {"zipf0.9", 0.9}, {"zipf1.2", 1.2}};
+    const size_t sketch_budget = 256 * 1024;
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        if (!csv) {
+            std::cerr << "Error: Could not create file " << csv_path << std::endl;
+            return 1;
+        }
+        csv << "section,policy,workload,capacity,ns_per_access,allocs_per_access,peak_heap_mb,hit_rate,rate\n";
+    }
+
+    std::cout << "Policies: " << request_count << " requests over " << key_count << " keys, median of "
+              << repetitions << std::endl;
+    std::cout << std::left << std::setw(12) << "Policy" << std::setw(10) << "Workload" << std::right
+              << std::setw(10) << "Capacity" << std::setw(10) << "ns/acc" << std::setw(12) << "allocs/acc"
+              << std::setw(12) << "heap MB" << std::setw(10) << "HitRate" << std::endl;
+    std::cout << std::fixed;
+
+    for (const Workload& workload : workloads) {
+        std::vector<TraceRecord> requests = zipfRequests(request_count, key_count, workload.skew, 42);
+        size_t distinct = 0;
+        std::vector<TraceRecord> dense = denseRequests(requests, distinct);
+
+        for (size_t capacity : cache_sizes) {
+            int size = static_cast<int>(capacity);
+            auto report = [&](const char* policy, const CaseResult& r) {
+                std::cout << std::left << std::setw(12) << policy << std::setw(10) << workload.name << std::right
+                          << std::setw(10) << capacity << std::setprecision(1) << std::setw(10) << r.ns_per_access
+                          << std::setprecision(3) << std::setw(12) << r.allocations_per_access
+                          << std::setprecision(1) << std::setw(12) << r.peak_heap_mb << std::setw(9) << r.hit_rate
+                          << "%" << std::endl;
+                if (csv.is_open()) {
+                    csv << "policy," << policy << "," << workload.name << "," << capacity << "," << r.ns_per_access
+                        << "," << r.allocations_per_access << "," << r.peak_heap_mb << "," << r.hit_rate << ",\n";
+                }
+            };
+
+            report("ARC", runCase([&] { return std::unique_ptr<ARC_Cache>(new ARC_Cache(capacity)); },
+                                  requests, repetitions));
+            report("LARC", runCase([&] { return std::unique_ptr<LARC_Cache>(new LARC_Cache(capacity)); },
+                                   requests, repetitions));
+            report("LRU", runCase([&] { return std::unique_ptr<LRU_Cache>(new LRU_Cache(capacity)); },
+                                  requests, repetitions));
+            report("NHIT", runCase([&] { return std::unique_ptr<NHitCache>(new NHitCache(size, 2)); },
+                                   requests, repetitions));
+            report("NHITCMS", runCase([&] {
+                       return std::unique_ptr<SketchNHitCache>(new SketchNHitCache(size, 2, sketch_budget));
+                   }, requests, repetitions));
+            // Belady preprocessing happens in the constructor, outside the timed loop
+            report("BELADY", runCase([&] {
+                       return std::unique_ptr<ExactBeladyCache>(new ExactBeladyCache(size, requests));
+                   }, requests, repetitions));
+            report("BELADY/4", runCase([&] {
+                       return std::unique_ptr<BeladyCache>(new BeladyCache(size, 4, requests));
+                   }, requests, repetitions));
+            report("ARC/dense", runCase([&] { return std::unique_ptr<DenseARC_Cache>(new DenseARC_Cache(capacity, distinct)); },
+                                        dense, repetitions));
+            report("LARC/dense", runCase([&] {
+                       return std::unique_ptr<DenseLARC_Cache>(new DenseLARC_Cache(capacity, distinct));
+                   }, dense, repetitions));
+            report("LRU/dense", runCase([&] { return std::unique_ptr<DenseLRU_Cache>(new DenseLRU_Cache(capacity, distinct)); },
+                                        dense, repetitions));
+            report("NHIT/dense", runCase([&] {
+                       return std::unique_ptr<DenseNHitCache>(new DenseNHitCache(size, 2, distinct));
+                   }, dense, repetitions));
+        }
+    }
+
+    // Parsers: a seeded CSV trace and its binary conversion
+    const std::string csv_trace = "cachesim_bench_trace.csv";
+    const std::string binary_trace = "cachesim_bench_trace.bin";
+    {
+        std::vector<TraceRecord> requests = zipfRequests(request_count, key_count, 0.9, 7);
+        FILE* out = fopen(csv_trace.c_str(), "w");
+        if (out == nullptr) {
+            std::cerr << "Error: Could not create file " << csv_trace << std::endl;
+            return 1;
+        }
+        for (const TraceRecord& r : requests) {
+            fprintf(out, "%lld,%u,%lld,%u,%s\n", 1600000000000000000LL + r.timestamp, r.response_time, r.offset,
+                    r.size, r.type == OpType::Read ? "Read" : "Write");
+        }
+        fclose(out);
+
+        BinaryTraceWriter writer;
+        if (!writer.open(binary_trace)) {
+            std::cerr << "Error: Could not create file " << binary_trace << std::endl;
+            return 1;
+        }
+        for (const TraceRecord& r : requests) writer.write(r);
+        writer.close();
+    }
+
+    std::cout << std::endl << "Parsers: " << request_count << " lines, median of " << repetitions << std::endl;
+    std::cout << std::left << std::setw(12) << "Format" << std::right << std::setw(16) << "lines/sec"
+              << std::setw(12) << "ns/line" << std::setw(12) << "allocs" << std::endl;
+    for (const std::string& path : {csv_trace, binary_trace}) {
+        std::vector<double> times;
+        long long allocations = 0;
+        for (int r = 0; r < repetitions; r++) {
+            long long allocations_before = alloc_count::allocations;
+            auto started = std::chrono::steady_clock::now();
+            TraceReader reader(path);
+            TraceRecord record;
+            long long lines = 0, checksum = 0;
+            while (reader.next(record)) {
+                lines++;
+                checksum += record.offset;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            if (lines != static_cast<long long>(request_count) || checksum == 0) {
+                std::cerr << "Error: Parsed " << lines << " lines from " << path << std::endl;
+                return 1;
+            }
+            times.push_back(seconds);
+            allocations = alloc_count::allocations - allocations_before;
+        }
+        std::sort(times.begin(), times.end());
+        double seconds = times[times.size() / 2];
+        const char* format = path == csv_trace ? "CSV" : "binary";
+        std::cout << std::left << std::setw(12) << format << std::right << std::setprecision(0) << std::setw(16)
+                  << request_count / seconds << std::setprecision(1) << std::setw(12)
+                  << seconds * 1e9 / request_count << std::setw(12) << allocations << std::endl;
+        if (csv.is_open()) {
+            csv << "parser," << format << ",,,," << static_cast<double>(allocations) / request_count << ",,,"
+                << request_count / seconds << "\n";
+        }
+    }
+    std::remove(csv_trace.c_str());
+    std::remove(binary_trace.c_str());
+
+    std::cout << std::endl << "Peak RSS: " << std::setprecision(1) << peakRssMb() << " MB" << std::endl;
+    return 0;
+}
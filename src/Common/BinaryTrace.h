@@ -0,0 +1,182 @@
+#pragma once
+
+// Compact fixed-width binary trace format.
+//
+// File layout (little-endian):
+//   BinaryTraceHeader (32 bytes)
+//   entry_count x BinaryTraceEntry (24 bytes each)
+//
+// Each entry stores the timestamp as a delta from the previous request, the
+// 64-bit offset, the request size, the request type and the recorded response
+// time. Deltas that do not fit in the 30-bit field (about one second) are
+// written as an extra escape entry that carries the full signed delta in its
+// offset field. Version 1 files had no response time and must be converted
+// again.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TraceRecord.h"
+
+static const char BINARY_TRACE_MAGIC[8] = {'C', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+static const uint32_t BINARY_TRACE_VERSION = 2;
+
+struct BinaryTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t entry_count;      // Including escape entries
+    int64_t first_timestamp;   // Timestamp the first delta is relative to
+};
+
+struct BinaryTraceEntry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t delta_type;       // Bits 30-31: entry kind, bits 0-29: timestamp delta
+    uint32_t response_time;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BinaryTraceHeader) == 32, "unexpected BinaryTraceHeader layout");
+static_assert(sizeof(BinaryTraceEntry) == 24, "unexpected BinaryTraceEntry layout");
+
+namespace binary_trace {
+
+const uint32_t DELTA_BITS = 30;
+const uint32_t DELTA_MASK = (1u << DELTA_BITS) - 1;
+const uint32_t KIND_READ = 0;
+const uint32_t KIND_WRITE = 1;
+const uint32_t KIND_OTHER = 2;
+const uint32_t KIND_ESCAPE = 3;    // offset field holds a full int64 timestamp delta
+
+inline uint32_t kindOf(OpType type) {
+    switch (type) {
+        case OpType::Read: return KIND_READ;
+        case OpType::Write: return KIND_WRITE;
+        default: return KIND_OTHER;
+    }
+}
+
+inline OpType opTypeOf(uint32_t kind) {
+    if (kind == KIND_READ) return OpType::Read;
+    if (kind == KIND_WRITE) return OpType::Write;
+    return OpType::Other;
+}
+
+inline bool hasMagic(const char* data, size_t size) {
+    return size >= sizeof(BinaryTraceHeader) && memcmp(data, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0;
+}
+
+// Decode entries from [cursor, end) into record; returns false at the end
+inline bool decodeNext(const BinaryTraceEntry*& cursor, const BinaryTraceEntry* end,
+                       long long& last_timestamp, TraceRecord& record) {
+    while (cursor < end) {
+        const BinaryTraceEntry& entry = *cursor++;
+        uint32_t kind = entry.delta_type >> DELTA_BITS;
+        if (kind == KIND_ESCAPE) {
+            last_timestamp += static_cast<int64_t>(entry.offset);
+            continue;
+        }
+        last_timestamp += entry.delta_type & DELTA_MASK;
+        record.timestamp = last_timestamp;
+        record.offset = static_cast<long long>(entry.offset);
+        record.size = entry.size;
+        record.type = opTypeOf(kind);
+        record.response_time = entry.response_time;
+        return true;
+    }
+    return false;
+}
+
+} // namespace binary_trace
+
+// Buffered writer producing the binary trace format
+class BinaryTraceWriter {
+private:
+    FILE* out = nullptr;
+    std::vector<BinaryTraceEntry> buffer;
+    BinaryTraceHeader header;
+    long long last_timestamp = 0;
+    bool have_first = false;
+    bool write_error = false;
+
+    void flush() {
+        if (buffer.empty()) return;
+        if (fwrite(buffer.data(), sizeof(BinaryTraceEntry), buffer.size(), out) != buffer.size()) {
+            write_error = true;
+        }
+        buffer.clear();
+    }
+
+    void push(const BinaryTraceEntry& entry) {
+        buffer.push_back(entry);
+        header.entry_count++;
+        if (buffer.size() == buffer.capacity()) flush();
+    }
+
+public:
+    BinaryTraceWriter() {
+        buffer.reserve(1 << 16);
+        memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+        header.version = BINARY_TRACE_VERSION;
+        header.entry_size = sizeof(BinaryTraceEntry);
+        header.entry_count = 0;
+        header.first_timestamp = 0;
+    }
+    ~BinaryTraceWriter() { close(); }
+
+    BinaryTraceWriter(const BinaryTraceWriter&) = delete;
+    BinaryTraceWriter& operator=(const BinaryTraceWriter&) = delete;
+
+    bool open(const std::string& filename) {
+        out = fopen(filename.c_str(), "wb");
+        if (out == nullptr) return false;
+        // Placeholder header, rewritten on close once the count is known
+        return fwrite(&header, sizeof(header), 1, out) == 1;
+    }
+
+    void write(const TraceRecord& record) {
+        if (!have_first) {
+            header.first_timestamp = record.timestamp;
+            last_timestamp = record.timestamp;
+            have_first = true;
+        }
+        long long delta = record.timestamp - last_timestamp;
+        if (delta < 0 || delta > static_cast<long long>(binary_trace::DELTA_MASK)) {
+            BinaryTraceEntry escape;
+            escape.offset = static_cast<uint64_t>(delta);
+            escape.size = 0;
+            escape.response_time = 0;
+            escape.reserved = 0;
+            escape.delta_type = binary_trace::KIND_ESCAPE << binary_trace::DELTA_BITS;
+            push(escape);
+            delta = 0;
+        }
+        last_timestamp = record.timestamp;
+
+        BinaryTraceEntry entry;
+        entry.offset = static_cast<uint64_t>(record.offset);
+        entry.size = record.size;
+        entry.response_time = record.response_time;
+        entry.reserved = 0;
+        entry.delta_type = (binary_trace::kindOf(record.type) << binary_trace::DELTA_BITS) | static_cast<uint32_t>(delta);
+        push(entry);
+    }
+
+    // Flush pending entries and finalize the header; returns false on I/O error
+    bool close() {
+        if (out == nullptr) return true;
+        flush();
+        bool ok = !write_error;
+        ok = ok && fseek(out, 0, SEEK_SET) == 0;
+        ok = ok && fwrite(&header, sizeof(header), 1, out) == 1;
+        ok = (fclose(out) == 0) && ok;
+        out = nullptr;
+        return ok;
+    }
+
+    uint64_t getEntryCount() const { return header.entry_count; }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+// Hit/miss counters shared by every policy and driver
+
+#include <unordered_set>
+
+#include "TraceRecord.h"
+
+struct CacheStats {
+    long long total_requests = 0;
+    long long total_hits = 0;
+    long long total_misses = 0;
+    long long cold_misses = 0;
+    long long total_reads = 0;
+    long long total_writes = 0;
+    long long total_read_hits = 0;
+    long long total_read_misses = 0;
+    long long total_write_hits = 0;
+    long long total_write_misses = 0;
+
+    // Requests that are not reads are counted as writes
+    void record(bool hit, OpType type) {
+        total_requests++;
+        if (type == OpType::Read) {
+            total_reads++;
+            if (hit) {
+                total_hits++;
+                total_read_hits++;
+            } else {
+                total_misses++;
+                total_read_misses++;
+            }
+        } else {
+            total_writes++;
+            if (hit) {
+                total_hits++;
+                total_write_hits++;
+            } else {
+                total_misses++;
+                total_write_misses++;
+            }
+        }
+    }
+
+    double hitRate() const {
+        return total_requests > 0 ? (100.0 * total_hits / total_requests) : 0;
+    }
+};
+
+// Detects the first reference to each key (compulsory misses)
+class ColdMissTracker {
+private:
+    std::unordered_set<long long> seen_offsets;
+
+public:
+    // Returns true if key has never been seen before
+    bool firstReference(long long key) {
+        return seen_offsets.insert(key).second;
+    }
+
+    // Offsets seen so far (see Snapshot.h)
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(seen_offsets.size());
+        for (long long key : seen_offsets) out.putI64(key);
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t count;
+        if (!in.getSize(count, in.remaining())) return false;
+        seen_offsets.clear();
+        seen_offsets.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            long long key;
+            if (!in.getI64(key)) return false;
+            seen_offsets.insert(key);
+        }
+        return true;
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+// Checkpoints of a simulation run, for warm starts.
+//
+// A checkpoint holds a policy's complete state (see Snapshot.h), the run's
+// CacheStats and the offsets it has seen, so that cold misses stay exact.
+// A checkpoint at time T is taken before the run's first request at or after
+// T, and covers every request of the run before it in the trace. It records
+// that request's position, so a resumed run continues at the same place in
+// the trace even when timestamps are out of order. Each checkpoint is a file
+// <prefix>-<seconds>s.snap, and <prefix>.ckpt lists them one per line as
+// "<time in ns> <file>". A windowed run restores the latest checkpoint at or
+// before its start time, and then replays only the requests in between.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "CacheStats.h"
+#include "Snapshot.h"
+#include "TraceReader.h"
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'S', 'S', 'N', 'A', 'P', '0', '2'};
+
+struct CheckpointInfo {
+    std::string policy;            // Policy::name() of the saved policy
+    long long first_timestamp = 0; // Of the trace; times are relative to it
+    long long run_start = 0;       // Where the checkpointing run started, in ns
+    long long time = 0;            // Of the checkpoint, in ns
+    TracePosition resume;          // Of the run's next request
+    CacheStats stats;              // Of the run up to the checkpoint
+};
+
+namespace checkpoint_detail {
+
+// CacheStats counters in the order they are stored
+long long CacheStats::* const STAT_FIELDS[] = {
+    &CacheStats::total_requests, &CacheStats::total_hits, &CacheStats::total_misses,
+    &CacheStats::cold_misses, &CacheStats::total_reads, &CacheStats::total_writes,
+    &CacheStats::total_read_hits, &CacheStats::total_read_misses, &CacheStats::total_write_hits,
+    &CacheStats::total_write_misses};
+
+} // namespace checkpoint_detail
+
+template <class Policy>
+bool saveCheckpoint(const std::string& filename, const Policy& policy, const CheckpointInfo& info,
+                    const ColdMissTracker& cold_tracker) {
+    SnapshotWriter out;
+    out.putBytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    out.putString(info.policy);
+    out.putI64(info.first_timestamp);
+    out.putI64(info.run_start);
+    out.putI64(info.time);
+    out.putU64(info.resume.position);
+    out.putI64(info.resume.decoder_state);
+    out.putI64(info.resume.timestamp);
+    for (long long CacheStats::* field : checkpoint_detail::STAT_FIELDS) out.putI64(info.stats.*field);
+    cold_tracker.saveState(out);
+    policy.saveState(out);
+    return out.writeFile(filename);
+}
+
+// Restore a checkpoint into a newly constructed policy. On failure, error
+// says why.
+template <class Policy>
+bool loadCheckpoint(const std::string& filename, Policy& policy, CheckpointInfo& info,
+                    ColdMissTracker& cold_tracker, std::string& error) {
+    SnapshotReader in;
+    if (!in.readFile(filename)) {
+        error = "could not read " + filename;
+        return false;
+    }
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    if (!in.getBytes(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC)) {
+        error = filename + " is not a checkpoint";
+        return false;
+    }
+    bool ok = in.getString(info.policy) && in.getI64(info.first_timestamp) && in.getI64(info.run_start)
+              && in.getI64(info.time) && in.getU64(info.resume.position) && in.getI64(info.resume.decoder_state)
+              && in.getI64(info.resume.timestamp);
+    for (long long CacheStats::* field : checkpoint_detail::STAT_FIELDS) ok = ok && in.getI64(info.stats.*field);
+    if (ok && info.policy != Policy::name()) {
+        error = filename + " holds " + info.policy + " state, not " + Policy::name();
+        return false;
+    }
+    if (!ok || !cold_tracker.loadState(in)) {
+        error = filename + " is truncated or corrupt";
+        return false;
+    }
+    if (!policy.loadState(in) || !in.atEnd()) {
+        error = filename + " does not match the policy's parameters, or is corrupt";
+        return false;
+    }
+    return true;
+}
+
+inline std::string checkpointListName(const std::string& prefix) { return prefix + ".ckpt"; }
+
+inline std::string checkpointFileName(const std::string& prefix, long long time) {
+    return prefix + "-" + std::to_string(time / 1000000000LL) + "s.snap";
+}
+
+// Start an empty checkpoint list for prefix
+inline bool startCheckpointList(const std::string& prefix) {
+    std::ofstream list(checkpointListName(prefix), std::ios::trunc);
+    return static_cast<bool>(list);
+}
+
+inline bool addToCheckpointList(const std::string& prefix, long long time, const std::string& filename) {
+    std::ofstream list(checkpointListName(prefix), std::ios::app);
+    list << time << " " << filename << "\n";
+    return static_cast<bool>(list);
+}
+
+// Latest listed checkpoint at or before `time`; false if there is none
+inline bool findCheckpoint(const std::string& prefix, long long time, std::string& filename,
+                           long long& checkpoint_time) {
+    std::ifstream list(checkpointListName(prefix));
+    std::string line;
+    bool found = false;
+    while (std::getline(list, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) continue;
+        long long listed = std::atoll(line.c_str());
+        if (listed > time || (found && listed <= checkpoint_time)) continue;
+        checkpoint_time = listed;
+        filename = line.substr(space + 1);
+        found = true;
+    }
+    return found;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// Latency cost model over the trace's Response Time column.
+//
+// A miss is charged the response time recorded in the trace, since that is
+// what the device took to serve it. A hit is charged the configured service
+// time for its type instead. Times are in whatever unit the trace records.
+// Besides the mean, latencies go into log-bucketed histograms for tail
+// percentiles, and a byte-weighted mean (sum of size x latency over total
+// bytes) lets large transfers count in proportion to their size.
+
+#include <cstdint>
+#include <vector>
+
+#include "TraceRecord.h"
+
+struct CostModel {
+    uint32_t read_hit_time = 0;    // Service time of a read hit
+    uint32_t write_hit_time = 0;   // Service time of a write (or other) hit
+
+    uint32_t hitTime(OpType type) const { return type == OpType::Read ? read_hit_time : write_hit_time; }
+};
+
+// Histogram of non-negative integers. Values below 2^SUB_BITS have a bucket
+// each; above that every power of two is split into 2^SUB_BITS buckets, so a
+// percentile is within 1/64 of the true value.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 6;
+    static constexpr uint64_t SUB_COUNT = 1ULL << SUB_BITS;
+
+    std::vector<long long> counts;
+    long long total = 0;
+
+    static int floorLog2(uint64_t value) {
+        int log = 0;
+        for (int step = 32; step > 0; step /= 2) {
+            if (value >> step) {
+                value >>= step;
+                log += step;
+            }
+        }
+        return log;
+    }
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_COUNT) return static_cast<size_t>(value);
+        int shift = floorLog2(value) - SUB_BITS;
+        return static_cast<size_t>((static_cast<uint64_t>(shift + 1) << SUB_BITS) + ((value >> shift) - SUB_COUNT));
+    }
+
+    // Smallest value that falls into the bucket
+    static uint64_t lowerBound(size_t bucket) {
+        if (bucket < SUB_COUNT) return bucket;
+        int shift = static_cast<int>(bucket >> SUB_BITS) - 1;
+        return (SUB_COUNT + (bucket & (SUB_COUNT - 1))) << shift;
+    }
+
+public:
+    LatencyHistogram() : counts((64 - SUB_BITS + 1) * SUB_COUNT, 0) {}
+
+    void record(uint64_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+    }
+
+    long long count() const { return total; }
+
+    // Value at quantile q in [0, 1], as the midpoint of its bucket
+    double percentile(double q) const {
+        if (total == 0) return 0;
+        long long rank = static_cast<long long>(q * static_cast<double>(total));
+        if (rank >= total) rank = total - 1;
+        long long seen = 0;
+        for (size_t bucket = 0; bucket < counts.size(); bucket++) {
+            seen += counts[bucket];
+            if (seen > rank) {
+                uint64_t low = lowerBound(bucket);
+                uint64_t high = bucket + 1 < counts.size() ? lowerBound(bucket + 1) : low + 1;
+                return (static_cast<double>(low) + static_cast<double>(high - 1)) / 2;
+            }
+        }
+        return 0;
+    }
+};
+
+// Latency of one policy next to the recorded (uncached) latency of the same requests
+struct CostStats {
+    LatencyHistogram latency;
+    LatencyHistogram device_latency;
+    double latency_sum = 0;
+    double device_latency_sum = 0;
+    double byte_latency_sum = 0;          // Sum of size x latency
+    double byte_device_latency_sum = 0;
+    long long requests = 0;
+    long long bytes = 0;
+    long long hit_bytes = 0;
+
+    void record(bool hit, const TraceRecord& record, const CostModel& model) {
+        uint32_t charged = hit ? model.hitTime(record.type) : record.response_time;
+        latency.record(charged);
+        device_latency.record(record.response_time);
+        latency_sum += charged;
+        device_latency_sum += record.response_time;
+        byte_latency_sum += static_cast<double>(record.size) * charged;
+        byte_device_latency_sum += static_cast<double>(record.size) * record.response_time;
+        requests++;
+        bytes += record.size;
+        if (hit) hit_bytes += record.size;
+    }
+
+    double meanLatency() const { return requests > 0 ? latency_sum / requests : 0; }
+    double meanDeviceLatency() const { return requests > 0 ? device_latency_sum / requests : 0; }
+    double byteWeightedLatency() const { return bytes > 0 ? byte_latency_sum / bytes : 0; }
+    double byteWeightedDeviceLatency() const { return bytes > 0 ? byte_device_latency_sum / bytes : 0; }
+    double byteHitRate() const { return bytes > 0 ? (100.0 * hit_bytes / bytes) : 0; }
+
+    // Share of the recorded device time the cache saves; negative if hits
+    // are charged more than the misses they replace
+    double savedPercent() const {
+        return device_latency_sum > 0 ? 100.0 * (device_latency_sum - latency_sum) / device_latency_sum : 0;
+    }
+    double byteWeightedSavedPercent() const {
+        return byte_device_latency_sum > 0
+                   ? 100.0 * (byte_device_latency_sum - byte_latency_sum) / byte_device_latency_sum
+                   : 0;
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+// Dense key remapping.
+//
+// Offsets are sparse 64-bit values, so every policy looks them up through a
+// hash index. A loaded window can be remapped once instead: each distinct
+// offset gets an id in [0, distinct), in order of first appearance. The
+// Dense* policy variants (DenseLRU_Cache, DenseARC_Cache, DenseLARC_Cache,
+// DenseNHitCache) then find entries by indexing arrays with the id. They
+// take the distinct count in their constructors and size those arrays once,
+// so access() never allocates. Ids keep the identity of offsets, so results
+// are exactly those of the hashed policies.
+
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+#include "CacheStats.h"
+#include "Profiler.h"
+#include "TraceColumns.h"
+
+// Fill columns.keys with the dense id of every offset. Returns false if the
+// window has too many distinct offsets for 32-bit ids.
+inline bool assignDenseKeys(TraceColumns& columns, size_t& distinct) {
+    std::unordered_map<long long, uint32_t> ids;
+    ids.reserve(columns.size() / 4 + 16);
+    columns.keys.resize(columns.size());
+
+    for (size_t i = 0; i < columns.size(); i++) {
+        auto inserted = ids.emplace(columns.offsets[i], static_cast<uint32_t>(ids.size()));
+        if (inserted.second && ids.size() == UINT32_MAX) {
+            std::cerr << "Error: Too many distinct offsets for dense keys" << std::endl;
+            columns.keys.clear();
+            return false;
+        }
+        columns.keys[i] = inserted.first->second;
+    }
+    distinct = ids.size();
+    return true;
+}
+
+// Run remapped columns through a Dense* policy. Ids are handed out in order
+// of first appearance, so a request is a first reference exactly when its id
+// is the next unused one, and cold misses need no lookup.
+template <class Policy>
+void simulateDense(const TraceColumns& columns, Policy& policy, CacheStats& stats) {
+    CACHESIM_PROFILE_SCOPE(simulate_scope, "simulate", Policy::name());
+    uint32_t next_new = 0;
+    for (size_t i = 0; i < columns.size(); i++) {
+        uint32_t key = columns.keys[i];
+        OpType type = columns.types[i];
+        bool hit = policy.access(key, type);
+        stats.record(hit, type);
+        if (key == next_new) {
+            next_new++;
+            if (!hit) stats.cold_misses++;
+        }
+    }
+    CACHESIM_PROFILE_ITEMS(simulate_scope, columns.size());
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+// Per-interval metrics stream.
+//
+// IntervalMetrics cuts a run into intervals of trace time or of request
+// count and emits one record per interval: requests, hits and misses by
+// read/write, cold misses, and the policy's internal state at the end of the
+// interval. A policy exposes its state with
+//     template <class Report> void reportState(Report& report) const;
+// calling report("name", value) for the same fields in the same order every
+// time. Policies without it get only the counters.
+//
+// Records are formatted into a large in-memory buffer that MetricsSink
+// writes out in blocks, so the per-request path only bumps counters.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Simulation.h"
+
+static const char METRICS_MAGIC[8] = {'C', 'S', 'M', 'E', 'T', 'R', 'C', '1'};
+
+// Buffered writer of metric rows. CSV by default; a path ending in ".bin"
+// selects the binary layout: the magic, a uint32 column count, each column
+// name as a uint16 length and its bytes, then rows of int64 values.
+class MetricsSink {
+private:
+    static const size_t BUFFER_BYTES = 1 << 20;
+
+    FILE* out = nullptr;
+    bool binary = false;
+    bool write_error = false;
+    std::vector<char> buffer;
+
+    void append(const void* data, size_t length) {
+        if (buffer.size() + length > BUFFER_BYTES) flush();
+        const char* bytes = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + length);
+    }
+
+    void flush() {
+        if (buffer.empty() || out == nullptr) return;
+        if (fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) write_error = true;
+        buffer.clear();
+    }
+
+public:
+    MetricsSink() { buffer.reserve(BUFFER_BYTES); }
+    ~MetricsSink() { close(); }
+
+    MetricsSink(const MetricsSink&) = delete;
+    MetricsSink& operator=(const MetricsSink&) = delete;
+
+    bool open(const std::string& filename) {
+        binary = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0;
+        out = fopen(filename.c_str(), binary ? "wb" : "w");
+        return out != nullptr;
+    }
+
+    void writeHeader(const std::vector<const char*>& columns) {
+        if (binary) {
+            append(METRICS_MAGIC, sizeof(METRICS_MAGIC));
+            uint32_t count = static_cast<uint32_t>(columns.size());
+            append(&count, sizeof(count));
+            for (const char* column : columns) {
+                uint16_t length = static_cast<uint16_t>(strlen(column));
+                append(&length, sizeof(length));
+                append(column, length);
+            }
+            return;
+        }
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (i > 0) append(",", 1);
+            append(columns[i], strlen(columns[i]));
+        }
+        append("\n", 1);
+    }
+
+    void writeRow(const std::vector<long long>& values) {
+        if (binary) {
+            for (long long value : values) {
+                int64_t v = value;
+                append(&v, sizeof(v));
+            }
+            return;
+        }
+        char text[24];
+        for (size_t i = 0; i < values.size(); i++) {
+            int length = snprintf(text, sizeof(text), i > 0 ? ",%lld" : "%lld", values[i]);
+            append(text, static_cast<size_t>(length));
+        }
+        append("\n", 1);
+    }
+
+    // Write out buffered rows; returns false if any write failed
+    bool close() {
+        if (out == nullptr) return !write_error;
+        flush();
+        bool ok = (fclose(out) == 0) && !write_error;
+        out = nullptr;
+        return ok;
+    }
+};
+
+// Every `length` ns of trace time, or every `length` requests
+struct MetricsInterval {
+    bool by_time = true;
+    long long length = 0;
+};
+
+// Parse "<n>s" (seconds of trace time) or "<n>r" (requests)
+inline bool parseMetricsInterval(const std::string& text, MetricsInterval& interval) {
+    if (text.size() < 2 || (text.back() != 's' && text.back() != 'r')) return false;
+    long long value = 0;
+    for (size_t i = 0; i + 1 < text.size(); i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    if (value <= 0) return false;
+    interval.by_time = text.back() == 's';
+    interval.length = interval.by_time ? value * NANOSECONDS_PER_SECOND : value;
+    return true;
+}
+
+namespace metrics_detail {
+
+// Collects the fields of a policy's reportState()
+struct StateCollector {
+    std::vector<const char*>* names;
+    std::vector<long long>* values;
+
+    void operator()(const char* name, long long value) {
+        if (names != nullptr) names->push_back(name);
+        values->push_back(value);
+    }
+};
+
+template <class Policy>
+inline auto reportState(const Policy& policy, StateCollector& collect, int)
+    -> decltype(policy.reportState(collect), void()) {
+    policy.reportState(collect);
+}
+
+template <class Policy>
+inline void reportState(const Policy&, StateCollector&, long) {}
+
+} // namespace metrics_detail
+
+class IntervalMetrics {
+private:
+    MetricsSink& sink;
+    MetricsInterval interval;
+    CacheStats current;
+    long long index = 0;
+    long long first_timestamp = 0;
+    long long interval_start = 0;     // Relative to the first request
+    long long last_timestamp = 0;
+    bool started = false;
+    bool header_written = false;
+    std::vector<long long> row;
+
+    template <class Policy>
+    void emit(const Policy& policy) {
+        row.assign({index, interval_start, last_timestamp - first_timestamp, current.total_requests,
+                    current.total_reads, current.total_writes, current.total_read_hits, current.total_write_hits,
+                    current.total_read_misses, current.total_write_misses, current.cold_misses});
+        std::vector<const char*> names;
+        metrics_detail::StateCollector collect{header_written ? nullptr : &names, &row};
+        metrics_detail::reportState(policy, collect, 0);
+        if (!header_written) {
+            std::vector<const char*> columns = {"interval", "start_ns", "end_ns", "requests", "reads", "writes",
+                                                "read_hits", "write_hits", "read_misses", "write_misses",
+                                                "cold_misses"};
+            columns.insert(columns.end(), names.begin(), names.end());
+            sink.writeHeader(columns);
+            header_written = true;
+        }
+        sink.writeRow(row);
+        index++;
+        current = CacheStats();
+    }
+
+public:
+    IntervalMetrics(MetricsSink& output, const MetricsInterval& every) : sink(output), interval(every) {}
+
+    // Call before the request reaches the policy; closes the interval it ends
+    template <class Policy>
+    void beforeRequest(const Policy& policy, const TraceRecord& record) {
+        if (!started) {
+            first_timestamp = record.timestamp;
+            started = true;
+        }
+        long long relative = record.timestamp - first_timestamp;
+        if (interval.by_time) {
+            if (relative >= interval_start + interval.length) {
+                if (current.total_requests > 0) emit(policy);
+                interval_start += (relative - interval_start) / interval.length * interval.length;
+            }
+        } else if (current.total_requests == 0) {
+            interval_start = relative;
+        }
+        last_timestamp = record.timestamp;
+    }
+
+    template <class Policy>
+    void afterRequest(const Policy& policy, OpType type, bool hit, bool cold) {
+        current.record(hit, type);
+        if (cold) current.cold_misses++;
+        if (!interval.by_time && current.total_requests == interval.length) emit(policy);
+    }
+
+    // Emit the last, partial interval
+    template <class Policy>
+    void finish(const Policy& policy) {
+        if (current.total_requests > 0) emit(policy);
+    }
+};
+
+// Feed one request to the policy, recording it in both the totals and the
+// current interval
+template <class Policy>
+inline void simulateRequestWithMetrics(Policy& policy, const TraceRecord& record, CacheStats& stats,
+                                       ColdMissTracker& cold_tracker, IntervalMetrics& metrics) {
+    metrics.beforeRequest(policy, record);
+    bool hit = policy.access(record.offset, record.type);
+    stats.record(hit, record.type);
+    bool cold = !hit && cold_tracker.firstReference(record.offset);
+    if (cold) stats.cold_misses++;
+    metrics.afterRequest(policy, record.type, hit, cold);
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+// Fixed-size node store for the policy cores.
+//
+// Policies keep their entries in a NodePool, link them into recency lists
+// with 32-bit indices and look them up by offset through the pool's
+// open-addressing index. Everything is sized once in the constructor, so
+// nothing is allocated per request. DenseNodePool replaces the hash index
+// with an array indexed by dense key ids.
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+const uint32_t NO_NODE = UINT32_MAX;
+
+// Doubly linked list of pool nodes, most recent at the head
+struct NodeList {
+    uint32_t head = NO_NODE;
+    uint32_t tail = NO_NODE;
+    size_t size = 0;
+};
+
+// Open-addressing index from any 64-bit key to its node. A linear-probing
+// table of node indices, at most half full; keys are read back from the
+// nodes through key_of(node), so a slot is only 4 bytes.
+class HashedKeyIndex {
+private:
+    std::vector<uint32_t> table;
+    uint64_t mask = 0;
+    int shift = 63;
+
+    // Fibonacci hashing; the high bits mix page-aligned offsets well
+    size_t home(long long key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    // Slot holding the key, or the empty slot where it would go
+    template <class KeyOf>
+    size_t probe(long long key, const KeyOf& key_of) const {
+        size_t slot = home(key);
+        while (table[slot] != NO_NODE && key_of(table[slot]) != key) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+public:
+    HashedKeyIndex(size_t node_count, size_t) {
+        size_t slots = 2;
+        while (slots < 2 * node_count) {
+            slots *= 2;
+            shift--;
+        }
+        table.assign(slots, NO_NODE);
+        mask = slots - 1;
+    }
+
+    template <class KeyOf>
+    uint32_t find(long long key, const KeyOf& key_of) const { return table[probe(key, key_of)]; }
+
+    template <class KeyOf>
+    void insert(long long key, uint32_t node, const KeyOf& key_of) { table[probe(key, key_of)] = node; }
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    template <class KeyOf>
+    void erase(long long key, const KeyOf& key_of) {
+        size_t slot = probe(key, key_of);
+        size_t next = (slot + 1) & mask;
+        while (table[next] != NO_NODE) {
+            // Move the entry back unless its home slot lies in (slot, next]
+            size_t h = home(key_of(table[next]));
+            if (((next - h) & mask) >= ((next - slot) & mask)) {
+                table[slot] = table[next];
+                slot = next;
+            }
+            next = (next + 1) & mask;
+        }
+        table[slot] = NO_NODE;
+    }
+
+    const void* slotAddress(long long key) const { return &table[home(key)]; }
+
+    bool accepts(long long) const { return true; }
+};
+
+// Index for dense keys in [0, key_count) (see DenseKeys.h): node_of[key]
+// directly, no hashing. The array is sized for every key up front.
+class DenseKeyIndex {
+private:
+    std::vector<uint32_t> node_of;
+
+public:
+    DenseKeyIndex(size_t, size_t key_count) : node_of(key_count, NO_NODE) {}
+
+    template <class KeyOf>
+    uint32_t find(long long key, const KeyOf&) const { return node_of[static_cast<size_t>(key)]; }
+
+    template <class KeyOf>
+    void insert(long long key, uint32_t node, const KeyOf&) { node_of[static_cast<size_t>(key)] = node; }
+
+    template <class KeyOf>
+    void erase(long long key, const KeyOf&) { node_of[static_cast<size_t>(key)] = NO_NODE; }
+
+    const void* slotAddress(long long key) const { return &node_of[static_cast<size_t>(key)]; }
+
+    bool accepts(long long key) const { return static_cast<uint64_t>(key) < node_of.size(); }
+};
+
+// Nodes are found by key through KeyIndex: NodePool hashes any offset,
+// DenseNodePool indexes an array by dense id. key_count is the number of
+// dense ids; hashed pools ignore it.
+template <class KeyIndex>
+class BasicNodePool {
+private:
+    struct Node {
+        long long key;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    // Key of a node, for the index
+    struct NodeKeys {
+        const std::vector<Node>& nodes;
+        long long operator()(uint32_t index) const { return nodes[index].key; }
+    };
+
+    std::vector<Node> nodes;
+    uint32_t free_head = NO_NODE;
+    uint32_t used = 0;
+    KeyIndex key_index;
+
+public:
+    explicit BasicNodePool(size_t count, size_t key_count = 0) : nodes(count), key_index(count, key_count) {}
+
+    long long key(uint32_t node) const { return nodes[node].key; }
+
+    // Node holding the key, or NO_NODE
+    uint32_t find(long long key) const { return key_index.find(key, NodeKeys{nodes}); }
+
+    // Start loading the key's index slot ahead of a find()
+    void prefetch(long long key) const {
+        const void* slot = key_index.slotAddress(key);
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(slot), _MM_HINT_T0);
+#else
+        __builtin_prefetch(slot);
+#endif
+    }
+
+    // Take a free node for a key that is not present; NO_NODE if the pool is full
+    uint32_t insert(long long key) {
+        uint32_t node;
+        if (free_head != NO_NODE) {
+            node = free_head;
+            free_head = nodes[node].next;
+        } else if (used < nodes.size()) {
+            node = used++;
+        } else {
+            return NO_NODE;
+        }
+        nodes[node].key = key;
+        key_index.insert(key, node, NodeKeys{nodes});
+        return node;
+    }
+
+    // Free a node that is not linked into any list
+    void erase(uint32_t node) {
+        key_index.erase(nodes[node].key, NodeKeys{nodes});
+        nodes[node].next = free_head;
+        free_head = node;
+    }
+
+    void pushFront(NodeList& list, uint32_t index) {
+        nodes[index].prev = NO_NODE;
+        nodes[index].next = list.head;
+        if (list.head != NO_NODE) nodes[list.head].prev = index;
+        list.head = index;
+        if (list.tail == NO_NODE) list.tail = index;
+        list.size++;
+    }
+
+    // Link the node just before `before`, or at the tail if `before` is NO_NODE
+    void insertBefore(NodeList& list, uint32_t before, uint32_t index) {
+        uint32_t after = before != NO_NODE ? nodes[before].prev : list.tail;
+        nodes[index].prev = after;
+        nodes[index].next = before;
+        if (after != NO_NODE) nodes[after].next = index;
+        else list.head = index;
+        if (before != NO_NODE) nodes[before].prev = index;
+        else list.tail = index;
+        list.size++;
+    }
+
+    uint32_t prev(uint32_t index) const { return nodes[index].prev; }
+    uint32_t next(uint32_t index) const { return nodes[index].next; }
+
+    void unlink(NodeList& list, uint32_t index) {
+        Node& node = nodes[index];
+        if (node.prev != NO_NODE) nodes[node.prev].next = node.next;
+        else list.head = node.next;
+        if (node.next != NO_NODE) nodes[node.next].prev = node.prev;
+        else list.tail = node.prev;
+        list.size--;
+    }
+
+    void moveToFront(NodeList& list, uint32_t index) {
+        if (list.head == index) return;
+        unlink(list, index);
+        pushFront(list, index);
+    }
+
+    // Write a list's keys, least recent first (see Snapshot.h)
+    template <class Writer>
+    void saveList(Writer& out, const NodeList& list) const {
+        out.putU64(list.size);
+        for (uint32_t node = list.tail; node != NO_NODE; node = nodes[node].prev) out.putI64(nodes[node].key);
+    }
+
+    // Rebuild an empty list from saveList() output. Fails on more than
+    // max_size keys, a key the index cannot hold, a key already in the pool,
+    // or a full pool.
+    template <class Reader>
+    bool loadList(Reader& in, NodeList& list, size_t max_size) {
+        size_t count;
+        if (!in.getSize(count, max_size)) return false;
+        for (size_t i = 0; i < count; i++) {
+            long long key;
+            if (!in.getI64(key) || !key_index.accepts(key) || find(key) != NO_NODE) return false;
+            uint32_t node = insert(key);
+            if (node == NO_NODE) return false;
+            pushFront(list, node);
+        }
+        return true;
+    }
+};
+
+using NodePool = BasicNodePool<HashedKeyIndex>;
+using DenseNodePool = BasicNodePool<DenseKeyIndex>;
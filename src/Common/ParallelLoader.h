@@ -0,0 +1,163 @@
+#pragma once
+
+// Multi-threaded loading of a trace window into memory.
+//
+// The window's range of the file is cut at stride starts of the trace index
+// (see TraceIndex::splitPoints). Every cut is at the start of a line (or
+// entry), and the cuts carry the decoder state, so the pieces decode
+// independently, on as many threads as there are cores. The index bounds
+// the requests of each piece, so the output is sized once and each piece is
+// decoded straight into its own slot. The slots are then closed up in file
+// order, so the result is exactly what a sequential read of the window
+// produces, and no second copy of the window is made.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TraceColumns.h"
+#include "TraceIndex.h"
+#include "TraceReader.h"
+
+namespace parallel_load {
+
+// Pieces smaller than this are not worth a thread
+const size_t MIN_STRIDES_PER_PIECE = 16;
+
+inline void resize(std::vector<TraceRecord>& out, size_t count) { out.resize(count); }
+
+inline void resize(TraceColumns& out, size_t count) {
+    out.timestamps.resize(count);
+    out.offsets.resize(count);
+    out.sizes.resize(count);
+    out.response_times.resize(count);
+    out.types.resize(count);
+}
+
+inline void store(std::vector<TraceRecord>& out, size_t i, const TraceRecord& record) { out[i] = record; }
+
+inline void store(TraceColumns& out, size_t i, const TraceRecord& record) {
+    out.timestamps[i] = record.timestamp;
+    out.offsets[i] = record.offset;
+    out.sizes[i] = record.size;
+    out.response_times[i] = record.response_time;
+    out.types[i] = record.type;
+}
+
+// Move count entries from `from` down to `to` (to <= from)
+template <class T>
+void moveDown(std::vector<T>& column, size_t from, size_t count, size_t to) {
+    if (from != to) std::copy(column.begin() + from, column.begin() + from + count, column.begin() + to);
+}
+
+inline void moveDown(TraceColumns& out, size_t from, size_t count, size_t to) {
+    moveDown(out.timestamps, from, count, to);
+    moveDown(out.offsets, from, count, to);
+    moveDown(out.sizes, from, count, to);
+    moveDown(out.response_times, from, count, to);
+    moveDown(out.types, from, count, to);
+}
+
+} // namespace parallel_load
+
+// Append every request of the open reader's file with a timestamp in
+// [start_time, end_time] to `into` (a std::vector<TraceRecord> or
+// TraceColumns), decoding pieces of the window in parallel. thread_count 0
+// uses every core. Returns the number of skipped malformed lines.
+template <class Output>
+size_t loadWindowParallel(const std::string& filename, TraceReader& reader, const TraceIndex& index,
+                          long long start_time, long long end_time, Output& into, unsigned thread_count = 0) {
+    using namespace parallel_load;
+
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+#ifdef CACHESIM_PROFILE
+    thread_count = 1;   // The profiler's counters follow this thread only
+#endif
+
+    index.restrictToWindow(reader, start_time, end_time);
+    uint64_t begin = reader.tell();
+    uint64_t limit = reader.getLimit();
+
+    // Cut at stride starts; a few pieces per thread even out uneven lines
+    size_t strides = static_cast<size_t>(limit > begin ? limit - begin : 0);
+    strides /= reader.isBinary() ? INDEX_STRIDE : INDEX_STRIDE * 32;
+    size_t wanted = std::min<size_t>(thread_count * 4, strides / MIN_STRIDES_PER_PIECE + 1);
+    std::vector<TraceIndexEntry> cuts = thread_count > 1 ? index.splitPoints(begin, limit, wanted)
+                                                         : std::vector<TraceIndexEntry>();
+
+    auto read_sequentially = [&]() {
+        into.reserve(into.size() + index.maxRequestsBetween(begin, limit));
+        TraceRecord record;
+        while (reader.next(record)) {
+            if (record.timestamp < start_time || record.timestamp > end_time) continue;
+            into.push_back(record);
+        }
+        return reader.getSkippedLines();
+    };
+    if (cuts.empty()) return read_sequentially();
+
+    // Piece p covers [starts[p], starts[p + 1])
+    std::vector<TraceIndexEntry> starts;
+    starts.push_back({begin, reader.getDecoderState(), 0, 0});
+    starts.insert(starts.end(), cuts.begin(), cuts.end());
+    starts.push_back({limit, 0, 0, 0});
+    size_t piece_count = starts.size() - 1;
+
+    // Piece p decodes into [slot[p], slot[p + 1]) of `into`
+    size_t base = into.size();
+    std::vector<size_t> slot(piece_count + 1, base);
+    for (size_t p = 0; p < piece_count; p++) {
+        slot[p + 1] = slot[p] + index.maxRequestsBetween(starts[p].position, starts[p + 1].position);
+    }
+    resize(into, slot[piece_count]);
+
+    std::vector<size_t> filled(piece_count, 0);
+    std::vector<size_t> skipped(piece_count, 0);
+    std::atomic<size_t> next_piece{0};
+    std::atomic<bool> overflowed{false};
+    auto work = [&]() {
+        TraceReader piece_reader(filename);
+        TraceRecord record;
+        for (size_t p = next_piece++; p < piece_count; p = next_piece++) {
+            piece_reader.rewind();
+            piece_reader.setLimit(starts[p + 1].position);
+            piece_reader.seek(starts[p].position, starts[p].decoder_state);
+            size_t at = slot[p];
+            while (piece_reader.next(record)) {
+                if (record.timestamp < start_time || record.timestamp > end_time) continue;
+                if (at == slot[p + 1]) {
+                    overflowed = true;
+                    break;
+                }
+                store(into, at++, record);
+            }
+            filled[p] = at - slot[p];
+            skipped[p] = piece_reader.getSkippedLines();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<size_t>(thread_count, piece_count); t++) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+
+    // A piece longer than its strides means the index does not describe the file
+    if (overflowed) {
+        resize(into, base);
+        index.restrictToWindow(reader, start_time, end_time);
+        return read_sequentially();
+    }
+
+    // Close the gaps left by requests outside the window
+    size_t end = base, skipped_lines = 0;
+    for (size_t p = 0; p < piece_count; p++) {
+        moveDown(into, slot[p], filled[p], end);
+        end += filled[p];
+        skipped_lines += skipped[p];
+    }
+    resize(into, end);
+    return skipped_lines;
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+// Optional phase profiler.
+//
+// Build with -DCACHESIM_PROFILE to measure where a run spends its time. The
+// drivers mark three phases:
+//
+//   load      opening the trace, the timestamp index, paging the window in
+//   parse     decoding the window's requests (or generating a workload)
+//   simulate  the policy's access loop, one row per policy
+//
+// Each phase gets its wall time and, on Linux, user-space cycles,
+// instructions, last-level cache misses and branch misses from
+// perf_event_open. The counters follow the calling thread only, so profiled
+// builds decode on that thread instead of the pipeline and loader threads.
+// If the counters cannot be opened (not Linux, perf_event_paranoid, a
+// sandbox without the syscall), only times are reported. The report goes to
+// stderr when the program exits.
+//
+// Without the macro the CACHESIM_PROFILE_* macros expand to nothing, so
+// normal builds contain no profiling code.
+
+#ifdef CACHESIM_PROFILE
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace profile_detail {
+
+const int COUNTER_COUNT = 4;
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {"cycles", "instr", "LLC-miss", "br-miss"};
+
+// Hardware counters of the calling thread, opened once per process
+class HardwareCounters {
+private:
+    int fds[COUNTER_COUNT] = {-1, -1, -1, -1};
+    bool available = false;
+    std::string error;
+
+    void closeAll() {
+#if defined(__linux__)
+        for (int& fd : fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+public:
+    HardwareCounters() {
+#if defined(__linux__)
+        // The generic cache-miss event counts last-level misses on x86
+        const uint64_t configs[COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds[i] < 0) {
+                error = std::strerror(errno);
+                closeAll();
+                return;
+            }
+        }
+        available = true;
+#else
+        error = "perf_event_open needs Linux";
+#endif
+    }
+
+    ~HardwareCounters() { closeAll(); }
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    bool isAvailable() const { return available; }
+    const std::string& getError() const { return error; }
+
+    // Current counts, scaled up if the kernel multiplexed the counters
+    void read(double values[COUNTER_COUNT]) const {
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            values[i] = 0;
+#if defined(__linux__)
+            uint64_t data[3];   // value, time enabled, time running
+            if (!available || ::read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+            if (data[2] > 0) values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+#endif
+        }
+    }
+};
+
+struct PhaseRow {
+    std::string name;
+    long long runs = 0;
+    double seconds = 0;
+    double counts[COUNTER_COUNT] = {};
+    long long items = 0;   // Requests decoded or simulated
+};
+
+} // namespace profile_detail
+
+class Profiler {
+private:
+    profile_detail::HardwareCounters counters;
+    std::vector<profile_detail::PhaseRow> rows;
+
+    Profiler() = default;
+
+public:
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    ~Profiler() { print(std::cerr); }
+
+    const profile_detail::HardwareCounters& getCounters() const { return counters; }
+
+    void add(const std::string& name, double seconds, const double counts[], long long items) {
+        profile_detail::PhaseRow* row = nullptr;
+        for (profile_detail::PhaseRow& existing : rows) {
+            if (existing.name == name) row = &existing;
+        }
+        if (row == nullptr) {
+            rows.emplace_back();
+            row = &rows.back();
+            row->name = name;
+        }
+        row->runs++;
+        row->seconds += seconds;
+        for (int i = 0; i < profile_detail::COUNTER_COUNT; i++) row->counts[i] += counts[i];
+        row->items += items;
+    }
+
+    void print(std::ostream& out) const {
+        using namespace profile_detail;
+        if (rows.empty()) return;
+        bool with_counters = counters.isAvailable();
+
+        out << "Profile:" << std::endl;
+        if (!with_counters) out << "Hardware counters unavailable (" << counters.getError() << "), times only" << std::endl;
+        out << std::left << std::setw(18) << "Phase" << std::right << std::setw(6) << "Runs" << std::setw(12)
+            << "Seconds" << std::setw(14) << "Items" << std::setw(10) << "ns/item";
+        if (with_counters) {
+            for (const char* counter : COUNTER_NAMES) out << std::setw(15) << (std::string(counter) + "/item");
+            out << std::setw(8) << "IPC";
+        }
+        out << std::endl;
+
+        std::ios_base::fmtflags flags = out.flags();
+        out << std::fixed;
+        for (const PhaseRow& row : rows) {
+            out << std::left << std::setw(18) << row.name << std::right << std::setw(6) << row.runs
+                << std::setprecision(4) << std::setw(12) << row.seconds << std::setw(14) << row.items;
+            // The load phase has no items; its time is the figure of interest
+            if (row.items == 0) {
+                out << std::setw(10) << "-";
+                if (with_counters) {
+                    for (int i = 0; i < COUNTER_COUNT; i++) out << std::setw(15) << "-";
+                }
+            } else {
+                out << std::setprecision(1) << std::setw(10) << row.seconds * 1e9 / row.items;
+                if (with_counters) {
+                    for (int i = 0; i < COUNTER_COUNT; i++) out << std::setw(15) << row.counts[i] / row.items;
+                }
+            }
+            if (with_counters) {
+                out << std::setprecision(2) << std::setw(8) << (row.counts[0] > 0 ? row.counts[1] / row.counts[0] : 0);
+            }
+            out << std::endl;
+        }
+        out.flags(flags);
+    }
+};
+
+// Measures from construction to finish() or destruction and adds the result
+// to the phase's row. A policy name makes a separate row per policy.
+class ProfileScope {
+private:
+    std::string name;
+    std::chrono::steady_clock::time_point started;
+    double start_counts[profile_detail::COUNTER_COUNT];
+    long long items = 0;
+    bool finished = false;
+
+public:
+    explicit ProfileScope(const char* phase, const char* policy = nullptr)
+        : name(policy == nullptr ? phase : std::string(phase) + " " + policy) {
+        Profiler::instance().getCounters().read(start_counts);
+        started = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() { finish(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    void addItems(long long count) { items += count; }
+
+    void finish() {
+        if (finished) return;
+        finished = true;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        double counts[profile_detail::COUNTER_COUNT];
+        Profiler& profiler = Profiler::instance();
+        profiler.getCounters().read(counts);
+        for (int i = 0; i < profile_detail::COUNTER_COUNT; i++) counts[i] -= start_counts[i];
+        profiler.add(name, seconds, counts, items);
+    }
+};
+
+#define CACHESIM_PROFILE_SCOPE(var, ...) ProfileScope var(__VA_ARGS__)
+#define CACHESIM_PROFILE_ITEMS(var, count) var.addItems(static_cast<long long>(count))
+#define CACHESIM_PROFILE_END(var) var.finish()
+
+#else
+
+#define CACHESIM_PROFILE_SCOPE(var, ...)
+#define CACHESIM_PROFILE_ITEMS(var, count) ((void)sizeof(count))
+#define CACHESIM_PROFILE_END(var)
+
+#endif
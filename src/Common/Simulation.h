@@ -0,0 +1,294 @@
+#pragma once
+
+// Shared simulation driver.
+//
+// A policy is any class with
+//     bool access(long long key, OpType type);   // true on a cache hit
+// The driver is a template over the policy type, so access() is inlined
+// into the trace loop and statistics are kept in one place for every policy.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CacheStats.h"
+#include "ParallelLoader.h"
+#include "Profiler.h"
+#include "TraceIndex.h"
+#include "TracePipeline.h"
+#include "TraceReader.h"
+#include "Workload.h"
+
+const long long NANOSECONDS_PER_SECOND = 1000000000LL;
+
+// Requests in [start_time, end_time], relative to the first request, in ns
+struct TimeWindow {
+    long long start_time;
+    long long end_time;
+};
+
+inline TimeWindow windowFromSeconds(long long start_seconds, long long end_seconds) {
+    return {start_seconds * NANOSECONDS_PER_SECOND, end_seconds * NANOSECONDS_PER_SECOND};
+}
+
+// Feed one request to the policy and record the outcome
+template <class Policy>
+inline void simulateRequest(Policy& policy, const TraceRecord& record, CacheStats& stats,
+                            ColdMissTracker* cold_tracker) {
+    bool hit = policy.access(record.offset, record.type);
+    stats.record(hit, record.type);
+    if (!hit && cold_tracker != nullptr && cold_tracker->firstReference(record.offset)) {
+        stats.cold_misses++;
+    }
+}
+
+// Timestamp of the trace's first request, which window times are relative
+// to (0 for generated workloads). Returns false if the trace could not be
+// opened.
+inline bool firstTraceTimestamp(const std::string& filename, long long& first_timestamp) {
+    first_timestamp = 0;
+    if (isWorkloadName(filename)) return true;
+
+    TraceReader reader(filename);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    TraceIndex index;
+    index.loadOrBuild(filename, reader);
+    first_timestamp = index.getFirstTimestamp();
+    return true;
+}
+
+// Call visit(record) for every request of the window, in trace order. The
+// filename may also be a generated workload (see Workload.h). With a core to
+// spare, file traces are read and decoded on pipeline threads (see
+// TracePipeline.h) while visit() runs on the caller's thread.
+// Returns false if the trace could not be opened.
+template <class Visitor>
+bool forEachRequest(const std::string& filename, const TimeWindow& window, Visitor&& visit) {
+    if (isWorkloadName(filename)) {
+        WorkloadSpec spec;
+        std::string error;
+        if (!parseWorkloadSpec(filename, spec, error)) {
+            std::cerr << "Error: Bad workload " << filename << ": " << error << std::endl;
+            return false;
+        }
+        // Generated timestamps start at 0 and only grow
+        WorkloadGenerator generator(spec);
+        TraceRecord record;
+        while (generator.next(record)) {
+            if (record.timestamp < window.start_time) continue;
+            if (record.timestamp > window.end_time) break;
+            visit(record);
+        }
+        return true;
+    }
+
+    TraceReader reader(filename);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    TraceIndex index;
+    index.loadOrBuild(filename, reader);
+    long long start_time = index.getFirstTimestamp() + window.start_time;
+    long long end_time = index.getFirstTimestamp() + window.end_time;
+    index.restrictToWindow(reader, start_time, end_time);
+
+    if (usePipelinedReader()) {
+        readPipelined(reader, start_time, end_time, visit);
+    } else {
+        TraceRecord record;
+        while (reader.next(record)) {
+            if (record.timestamp < start_time || record.timestamp > end_time) continue;
+            visit(record);
+        }
+    }
+
+    if (reader.getSkippedLines() > 0) {
+        std::cerr << "Warning: Skipped " << reader.getSkippedLines() << " malformed rows." << std::endl;
+    }
+    return true;
+}
+
+// Like forEachRequest, but calls visit(record, position) with the position
+// of each request, and with a non-null `from` starts at that position
+// instead of the window's start. Resuming visits exactly the window's
+// requests that followed the position in the trace, whatever their
+// timestamps. Reads on the caller's thread. Returns false if the trace could
+// not be opened or `from` does not fit it.
+template <class Visitor>
+bool forEachRequestAt(const std::string& filename, const TimeWindow& window, const TracePosition* from,
+                      Visitor&& visit) {
+    TracePosition at;
+    TraceRecord record;
+    auto mismatch = [&]() {
+        std::cerr << "Error: Resume position does not match " << filename << std::endl;
+        return false;
+    };
+
+    if (isWorkloadName(filename)) {
+        WorkloadSpec spec;
+        std::string error;
+        if (!parseWorkloadSpec(filename, spec, error)) {
+            std::cerr << "Error: Bad workload " << filename << ": " << error << std::endl;
+            return false;
+        }
+        WorkloadGenerator generator(spec);
+        for (; generator.next(record); at.position++) {
+            if (from != nullptr && at.position < from->position) continue;
+            if (from != nullptr && at.position == from->position && record.timestamp != from->timestamp) {
+                return mismatch();
+            }
+            if (record.timestamp < window.start_time) continue;
+            if (record.timestamp > window.end_time) break;
+            at.timestamp = record.timestamp;
+            visit(record, at);
+        }
+        return true;
+    }
+
+    TraceReader reader(filename);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    // The request at the position must be the one it was taken before
+    if (from != nullptr) {
+        reader.seek(from->position, from->decoder_state);
+        if (reader.tell() != from->position || !reader.next(record) || record.timestamp != from->timestamp) {
+            return mismatch();
+        }
+    }
+
+    TraceIndex index;
+    index.loadOrBuild(filename, reader);
+    long long start_time = index.getFirstTimestamp() + window.start_time;
+    long long end_time = index.getFirstTimestamp() + window.end_time;
+    index.restrictToWindow(reader, start_time, end_time);
+
+    // Requests before the window's start stride are all earlier than the window
+    if (from != nullptr && from->position >= reader.tell()) reader.seek(from->position, from->decoder_state);
+    for (;;) {
+        at.position = reader.tell();
+        at.decoder_state = reader.getDecoderState();
+        if (!reader.next(record)) break;
+        if (record.timestamp < start_time || record.timestamp > end_time) continue;
+        at.timestamp = record.timestamp;
+        visit(record, at);
+    }
+
+    if (reader.getSkippedLines() > 0) {
+        std::cerr << "Warning: Skipped " << reader.getSkippedLines() << " malformed rows." << std::endl;
+    }
+    return true;
+}
+
+// Load every request of the window into memory (needed by offline policies),
+// as a std::vector<TraceRecord> or as TraceColumns. File traces are decoded
+// on all cores (see ParallelLoader.h). Returns false if the trace could not
+// be opened.
+template <class Output>
+bool loadTraceWindow(const std::string& filename, const TimeWindow& window, Output& requests) {
+    if (isWorkloadName(filename)) {
+        CACHESIM_PROFILE_SCOPE(parse_scope, "parse");
+        size_t before = requests.size();
+        bool ok = forEachRequest(filename, window, [&](const TraceRecord& record) {
+            requests.push_back(record);
+        });
+        CACHESIM_PROFILE_ITEMS(parse_scope, requests.size() - before);
+        return ok;
+    }
+
+    CACHESIM_PROFILE_SCOPE(load_scope, "load");
+    TraceReader reader(filename);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    TraceIndex index;
+    index.loadOrBuild(filename, reader);
+    long long start_time = index.getFirstTimestamp() + window.start_time;
+    long long end_time = index.getFirstTimestamp() + window.end_time;
+#ifdef CACHESIM_PROFILE
+    // Fault the window in here, so that parse measures decoding alone
+    index.restrictToWindow(reader, start_time, end_time);
+    volatile unsigned sink = reader.touch(reader.tell(), reader.getLimit());
+    (void)sink;
+#endif
+    CACHESIM_PROFILE_END(load_scope);
+
+    CACHESIM_PROFILE_SCOPE(parse_scope, "parse");
+    size_t before = requests.size();
+    size_t skipped_lines = loadWindowParallel(filename, reader, index, start_time, end_time, requests);
+    CACHESIM_PROFILE_ITEMS(parse_scope, requests.size() - before);
+
+    if (skipped_lines > 0) {
+        std::cerr << "Warning: Skipped " << skipped_lines << " malformed rows." << std::endl;
+    }
+    return true;
+}
+
+// Stream the window of a trace file through the policy.
+// Returns false if the trace could not be opened.
+template <class Policy>
+bool simulateTrace(const std::string& filename, const TimeWindow& window, Policy& policy,
+                   CacheStats& stats, bool track_cold_misses = true) {
+#ifdef CACHESIM_PROFILE
+    // Load the window first, so that every phase is measured on its own
+    TraceColumns columns;
+    if (!loadTraceWindow(filename, window, columns)) return false;
+    simulateColumns(columns, policy, stats, track_cold_misses);
+    return true;
+#else
+    ColdMissTracker cold_tracker;
+    ColdMissTracker* tracker = track_cold_misses ? &cold_tracker : nullptr;
+    return forEachRequest(filename, window, [&](const TraceRecord& record) {
+        simulateRequest(policy, record, stats, tracker);
+    });
+#endif
+}
+
+// Run already loaded requests through the policy
+template <class Policy>
+void simulateRecords(const std::vector<TraceRecord>& records, Policy& policy, CacheStats& stats,
+                     bool track_cold_misses = true) {
+    CACHESIM_PROFILE_SCOPE(simulate_scope, "simulate", Policy::name());
+    ColdMissTracker cold_tracker;
+    ColdMissTracker* tracker = track_cold_misses ? &cold_tracker : nullptr;
+    for (const TraceRecord& record : records) {
+        simulateRequest(policy, record, stats, tracker);
+    }
+    CACHESIM_PROFILE_ITEMS(simulate_scope, records.size());
+}
+
+// Run requests loaded as columns through the policy
+template <class Policy>
+void simulateColumns(const TraceColumns& columns, Policy& policy, CacheStats& stats,
+                     bool track_cold_misses = true) {
+    CACHESIM_PROFILE_SCOPE(simulate_scope, "simulate", Policy::name());
+    ColdMissTracker cold_tracker;
+    ColdMissTracker* tracker = track_cold_misses ? &cold_tracker : nullptr;
+    for (size_t i = 0; i < columns.size(); i++) {
+        simulateRequest(policy, columns.record(i), stats, tracker);
+    }
+    CACHESIM_PROFILE_ITEMS(simulate_scope, columns.size());
+}
+
+inline void printStats(const CacheStats& stats) {
+    std::cout << "Total Requests: " << stats.total_requests << std::endl;
+    std::cout << "Total Hits: " << stats.total_hits << std::endl;
+    std::cout << "Total Misses: " << stats.total_misses << std::endl;
+    std::cout << "Cold Misses: " << stats.cold_misses << std::endl;
+    std::cout << "Total Reads: " << stats.total_reads << std::endl;
+    std::cout << "Total Writes: " << stats.total_writes << std::endl;
+    std::cout << "Total Read Hits: " << stats.total_read_hits << std::endl;
+    std::cout << "Total Read Misses: " << stats.total_read_misses << std::endl;
+    std::cout << "Total Write Hits: " << stats.total_write_hits << std::endl;
+    std::cout << "Total Write Misses: " << stats.total_write_misses << std::endl;
+    std::cout << "Hit Rate: " << stats.hitRate() << "%" << std::endl;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Parsing of cache sizes typed at a prompt or written in a sweep spec.
+
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Largest cache size every policy accepts; N-hit and Belady take int sizes
+const size_t MAX_CACHE_SIZE = INT_MAX;
+
+// Parse one cache size: digits only, in [1, MAX_CACHE_SIZE]
+inline bool parseCacheSize(const std::string& text, size_t& size) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    errno = 0;
+    unsigned long long value = std::strtoull(text.c_str(), nullptr, 10);
+    if (errno == ERANGE || value == 0 || value > MAX_CACHE_SIZE) return false;
+    size = static_cast<size_t>(value);
+    return true;
+}
+
+// Parse a comma-separated list of cache sizes. Returns false if an item is
+// not a valid size or the list is empty.
+inline bool parseSizeList(const std::string& text, std::vector<size_t>& sizes) {
+    sizes.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t size;
+        if (!parseCacheSize(item, size)) return false;
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// Policy state snapshots for checkpointing and warm starts.
+//
+// A policy that can be checkpointed provides
+//     template <class Writer> void saveState(Writer& out) const;
+//     template <class Reader> bool loadState(Reader& in);   // into a new instance
+// saveState writes the policy's parameters and its complete state (list
+// orders, ghost lists, adaptive parameters, access counts). loadState
+// rejects a snapshot whose parameters differ from the instance's. A restored
+// policy behaves exactly like the one that was saved.
+//
+// Values are written as LEB128 varints, with signed values zigzag-encoded,
+// so small counts and sizes take a byte or two.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class SnapshotWriter {
+private:
+    std::vector<uint8_t> buffer;
+
+public:
+    void putU64(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    void putI64(long long value) {
+        uint64_t bits = static_cast<uint64_t>(value);
+        putU64((bits << 1) ^ (value < 0 ? ~0ULL : 0));
+    }
+
+    void putBytes(const void* data, size_t length) {
+        putU64(length);
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + length);
+    }
+
+    void putString(const std::string& text) { putBytes(text.data(), text.size()); }
+
+    size_t size() const { return buffer.size(); }
+
+    bool writeFile(const std::string& filename) const {
+        FILE* out = fopen(filename.c_str(), "wb");
+        if (out == nullptr) return false;
+        bool ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+        return fclose(out) == 0 && ok;
+    }
+};
+
+// Every get fails once the data runs out or is malformed
+class SnapshotReader {
+private:
+    std::vector<uint8_t> buffer;
+    size_t position = 0;
+
+public:
+    bool readFile(const std::string& filename) {
+        FILE* in = fopen(filename.c_str(), "rb");
+        if (in == nullptr) return false;
+        buffer.clear();
+        position = 0;
+        uint8_t chunk[1 << 16];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) buffer.insert(buffer.end(), chunk, chunk + got);
+        bool ok = !ferror(in);
+        fclose(in);
+        return ok;
+    }
+
+    bool getU64(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && position < buffer.size(); shift += 7) {
+            uint8_t byte = buffer[position++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        position = buffer.size();
+        return false;
+    }
+
+    bool getI64(long long& value) {
+        uint64_t bits;
+        if (!getU64(bits)) return false;
+        value = static_cast<long long>((bits >> 1) ^ (~(bits & 1) + 1));
+        return true;
+    }
+
+    // Read a size, failing if it exceeds `limit`
+    bool getSize(size_t& value, uint64_t limit) {
+        uint64_t raw;
+        if (!getU64(raw) || raw > limit) return false;
+        value = static_cast<size_t>(raw);
+        return true;
+    }
+
+    // Read bytes written by putBytes; the length must be exactly `length`
+    bool getBytes(void* data, size_t length) {
+        uint64_t stored;
+        if (!getU64(stored) || stored != length || buffer.size() - position < length) return false;
+        std::copy(buffer.begin() + position, buffer.begin() + position + length, static_cast<uint8_t*>(data));
+        position += length;
+        return true;
+    }
+
+    bool getString(std::string& text) {
+        uint64_t length;
+        if (!getU64(length) || length > buffer.size() - position) return false;
+        text.assign(buffer.begin() + position, buffer.begin() + position + length);
+        position += length;
+        return true;
+    }
+
+    size_t remaining() const { return buffer.size() - position; }
+    bool atEnd() const { return position == buffer.size(); }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// Bounded single-producer/single-consumer ring buffer.
+//
+// One thread pushes and one thread pops; neither takes a lock while the ring
+// has room and items. Each index is written by one side only and lives on
+// its own cache line. The blocking push() and pop() spin briefly, then
+// yield, and then sleep on a condition variable until the other side makes
+// progress, so a full ring holds the producer back and an empty one holds
+// the consumer back without burning a core. Either side may close() the
+// ring. After that, push() fails and pop() drains what is left and then
+// fails, which is how the end of a stream (or a cancellation) is signalled.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <class T>
+class SpscRing {
+private:
+    static const int SPIN_LIMIT = 64;    // Polls before yielding
+    static const int YIELD_LIMIT = 16;   // Yields before sleeping
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};   // Next slot to pop; written by the consumer
+    alignas(64) std::atomic<size_t> tail{0};   // Next slot to push; written by the producer
+    alignas(64) std::atomic<bool> closed{false};
+    alignas(64) std::atomic<int> sleepers{0};  // Threads asleep in backOff()
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+
+    bool hasRoom() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) != slots.size();
+    }
+
+    bool hasItem() const { return head.load(std::memory_order_relaxed) != tail.load(std::memory_order_acquire); }
+
+    // Wait for the other side: spin, then yield, then sleep until `ready`
+    // holds or the ring is closed. The fence pairs with the one in notify(),
+    // so either the sleeper sees the change or notify() sees the sleeper.
+    template <class Ready>
+    void backOff(int& rounds, Ready ready) {
+        if (++rounds < SPIN_LIMIT) return;
+        if (rounds < SPIN_LIMIT + YIELD_LIMIT) {
+            std::this_thread::yield();
+            return;
+        }
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake.wait(guard, [&] { return ready() || closed.load(std::memory_order_acquire); });
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Wake the other side if it is asleep
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        wake.notify_all();
+    }
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool tryPush(T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h) return false;
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    // Wait for room; returns false if the ring was closed first
+    bool push(T& value) {
+        int rounds = 0;
+        while (!tryPush(value)) {
+            if (closed.load(std::memory_order_acquire)) return false;
+            backOff(rounds, [this] { return hasRoom(); });
+        }
+        return true;
+    }
+
+    // Wait for an item; returns false once the ring is closed and empty
+    bool pop(T& value) {
+        int rounds = 0;
+        while (!tryPop(value)) {
+            // Items pushed before close() are visible once closed is
+            if (closed.load(std::memory_order_acquire)) return tryPop(value);
+            backOff(rounds, [this] { return hasItem(); });
+        }
+        return true;
+    }
+
+    void close() {
+        closed.store(true, std::memory_order_release);
+        notify();
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+// Loaded requests stored as one array per field. Offline analyses that only
+// need the offsets (Belady's next-use pass) then read 8 bytes per request
+// instead of a whole TraceRecord.
+
+#include <cstdint>
+#include <vector>
+
+#include "TraceRecord.h"
+
+struct TraceColumns {
+    std::vector<long long> timestamps;
+    std::vector<long long> offsets;
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> response_times;
+    std::vector<OpType> types;
+    std::vector<uint32_t> keys;     // Dense id of each offset; empty until assignDenseKeys()
+
+    size_t size() const { return offsets.size(); }
+    bool empty() const { return offsets.empty(); }
+
+    void reserve(size_t count) {
+        timestamps.reserve(count);
+        offsets.reserve(count);
+        sizes.reserve(count);
+        response_times.reserve(count);
+        types.reserve(count);
+    }
+
+    void push_back(const TraceRecord& record) {
+        timestamps.push_back(record.timestamp);
+        offsets.push_back(record.offset);
+        sizes.push_back(record.size);
+        response_times.push_back(record.response_time);
+        types.push_back(record.type);
+    }
+
+    TraceRecord record(size_t i) const {
+        return {timestamps[i], offsets[i], sizes[i], types[i], response_times[i]};
+    }
+};
+
+// Offsets of a loaded request sequence: the offset fields of a TraceRecord
+// array, or the offsets column of TraceColumns
+class OffsetView {
+private:
+    const char* base = nullptr;
+    size_t stride = sizeof(long long);
+    size_t count = 0;
+
+public:
+    OffsetView(const std::vector<TraceRecord>& records)
+        : base(records.empty() ? nullptr : reinterpret_cast<const char*>(&records[0].offset)),
+          stride(sizeof(TraceRecord)), count(records.size()) {}
+    OffsetView(const std::vector<long long>& offsets)
+        : base(reinterpret_cast<const char*>(offsets.data())), count(offsets.size()) {}
+
+    size_t size() const { return count; }
+    long long operator[](size_t i) const { return *reinterpret_cast<const long long*>(base + i * stride); }
+};
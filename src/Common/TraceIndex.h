@@ -0,0 +1,205 @@
+#pragma once
+
+// Sparse timestamp index stored next to a trace as "<trace>.idx".
+//
+// Every INDEX_STRIDE requests the index records the reader position together
+// with the largest timestamp seen before it and the smallest timestamp at or
+// after it. That is enough to seek past every request earlier than a window
+// start and to stop after the last request that can still fall inside the
+// window, even when the trace is not perfectly sorted. The index is built on
+// first use and rebuilt whenever the trace's size or modification time
+// changes.
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "TraceReader.h"
+
+static const char TRACE_INDEX_MAGIC[8] = {'C', 'S', 'T', 'I', 'D', 'X', '0', '1'};
+static const uint32_t TRACE_INDEX_VERSION = 1;
+static const uint32_t INDEX_STRIDE = 4096;
+
+struct TraceIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stride;
+    uint64_t trace_size;
+    int64_t trace_mtime;
+    int64_t first_timestamp;
+    uint64_t entry_count;
+    uint64_t end_position;     // Reader position after the last request
+    uint64_t binary;           // Non-zero if positions refer to a binary trace
+};
+
+struct TraceIndexEntry {
+    uint64_t position;         // TraceReader::tell() before the request
+    int64_t decoder_state;     // TraceReader::getDecoderState() at that position
+    int64_t prefix_max;        // Largest timestamp before this position
+    int64_t suffix_min;        // Smallest timestamp at or after this position
+};
+
+class TraceIndex {
+private:
+    TraceIndexHeader header;
+    std::vector<TraceIndexEntry> entries;
+
+    static bool traceStamp(const std::string& trace_filename, uint64_t& size, int64_t& mtime) {
+        std::error_code ec;
+        size = static_cast<uint64_t>(std::filesystem::file_size(trace_filename, ec));
+        if (ec) return false;
+        auto time = std::filesystem::last_write_time(trace_filename, ec);
+        if (ec) return false;
+        mtime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    bool load(const std::string& index_filename, uint64_t size, int64_t mtime, bool binary) {
+        FILE* in = fopen(index_filename.c_str(), "rb");
+        if (in == nullptr) return false;
+        TraceIndexHeader h;
+        bool ok = fread(&h, sizeof(h), 1, in) == 1 &&
+                  memcmp(h.magic, TRACE_INDEX_MAGIC, sizeof(h.magic)) == 0 &&
+                  h.version == TRACE_INDEX_VERSION &&
+                  h.trace_size == size && h.trace_mtime == mtime &&
+                  (h.binary != 0) == binary;
+        if (ok) {
+            entries.resize(static_cast<size_t>(h.entry_count));
+            ok = entries.empty() || fread(entries.data(), sizeof(TraceIndexEntry), entries.size(), in) == entries.size();
+        }
+        fclose(in);
+        if (!ok) {
+            entries.clear();
+            return false;
+        }
+        header = h;
+        return true;
+    }
+
+    bool save(const std::string& index_filename) const {
+        FILE* out = fopen(index_filename.c_str(), "wb");
+        if (out == nullptr) return false;
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        if (ok && !entries.empty()) {
+            ok = fwrite(entries.data(), sizeof(TraceIndexEntry), entries.size(), out) == entries.size();
+        }
+        ok = (fclose(out) == 0) && ok;
+        return ok;
+    }
+
+    void build(TraceReader& reader, uint64_t size, int64_t mtime) {
+        memcpy(header.magic, TRACE_INDEX_MAGIC, sizeof(header.magic));
+        header.version = TRACE_INDEX_VERSION;
+        header.stride = INDEX_STRIDE;
+        header.trace_size = size;
+        header.trace_mtime = mtime;
+        header.first_timestamp = 0;
+        header.binary = reader.isBinary() ? 1 : 0;
+        entries.clear();
+
+        std::vector<int64_t> stride_min;
+        reader.rewind();
+        TraceRecord record;
+        long long running_max = LLONG_MIN;
+        uint64_t count = 0;
+        uint64_t position = reader.tell();
+        long long state = reader.getDecoderState();
+        while (reader.next(record)) {
+            if (count % INDEX_STRIDE == 0) {
+                entries.push_back({position, state, running_max, LLONG_MAX});
+                stride_min.push_back(LLONG_MAX);
+            }
+            if (count == 0) header.first_timestamp = record.timestamp;
+            running_max = std::max(running_max, record.timestamp);
+            stride_min.back() = std::min<int64_t>(stride_min.back(), record.timestamp);
+            count++;
+            position = reader.tell();
+            state = reader.getDecoderState();
+        }
+        header.end_position = reader.tell();
+        header.entry_count = entries.size();
+
+        int64_t suffix_min = LLONG_MAX;
+        for (size_t i = entries.size(); i-- > 0;) {
+            suffix_min = std::min(suffix_min, stride_min[i]);
+            entries[i].suffix_min = suffix_min;
+        }
+        reader.rewind();
+    }
+
+public:
+    TraceIndex() { memset(&header, 0, sizeof(header)); }
+
+    // Load "<trace>.idx" if it matches the trace, otherwise build and save it.
+    // The reader must already be open on trace_filename.
+    void loadOrBuild(const std::string& trace_filename, TraceReader& reader) {
+        std::string index_filename = trace_filename + ".idx";
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        bool stamped = traceStamp(trace_filename, size, mtime);
+        if (stamped && load(index_filename, size, mtime, reader.isBinary())) return;
+
+        build(reader, size, mtime);
+        if (stamped && !save(index_filename)) {
+            std::cerr << "Warning: Could not write index " << index_filename << std::endl;
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    long long getFirstTimestamp() const { return header.first_timestamp; }
+
+    // Seek the reader to the first stride that may contain a request with
+    // timestamp >= start_time and stop it once no later request can have
+    // timestamp <= end_time. Requests outside the window may still be
+    // returned near both edges, so callers keep their own time filter.
+    void restrictToWindow(TraceReader& reader, long long start_time, long long end_time) const {
+        reader.rewind();
+        if (entries.empty()) return;
+
+        // Last stride whose preceding requests are all earlier than start_time
+        auto first = std::upper_bound(entries.begin(), entries.end(), start_time,
+            [](long long t, const TraceIndexEntry& e) { return e.prefix_max >= t; });
+        const TraceIndexEntry& from = (first == entries.begin()) ? *first : *(first - 1);
+
+        // First stride from which every request is later than end_time
+        auto last = std::upper_bound(entries.begin(), entries.end(), end_time,
+            [](long long t, const TraceIndexEntry& e) { return t < e.suffix_min; });
+        uint64_t limit = (last == entries.end()) ? header.end_position : last->position;
+
+        reader.setLimit(limit);
+        reader.seek(std::min<uint64_t>(from.position, limit), from.decoder_state);
+    }
+
+    // Most requests in [begin, limit) when begin is a stride start (as after
+    // restrictToWindow or splitPoints): a full stride per index entry
+    size_t maxRequestsBetween(uint64_t begin, uint64_t limit) const {
+        auto low = std::lower_bound(entries.begin(), entries.end(), begin,
+            [](const TraceIndexEntry& e, uint64_t p) { return e.position < p; });
+        auto high = std::lower_bound(low, entries.end(), limit,
+            [](const TraceIndexEntry& e, uint64_t p) { return e.position < p; });
+        return static_cast<size_t>(high - low) * header.stride;
+    }
+
+    // Up to parts - 1 stride starts strictly between begin and limit, evenly
+    // spaced by request count. A reader resumes at one with
+    // seek(position, decoder_state), so [begin, limit) can be decoded in
+    // independent pieces.
+    std::vector<TraceIndexEntry> splitPoints(uint64_t begin, uint64_t limit, size_t parts) const {
+        auto after = [](const TraceIndexEntry& e, uint64_t p) { return e.position <= p; };
+        auto low = std::lower_bound(entries.begin(), entries.end(), begin, after);
+        auto high = std::lower_bound(low, entries.end(), limit,
+            [](const TraceIndexEntry& e, uint64_t p) { return e.position < p; });
+        size_t available = static_cast<size_t>(high - low);
+        size_t count = std::min(parts > 0 ? parts - 1 : 0, available);
+        std::vector<TraceIndexEntry> points;
+        for (size_t k = 1; k <= count; k++) points.push_back(*(low + k * available / (count + 1)));
+        return points;
+    }
+};
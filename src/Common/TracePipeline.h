@@ -0,0 +1,117 @@
+#pragma once
+
+// Three-stage trace pipeline.
+//
+//   read stage    faults in the mapped file chunk by chunk, ahead of the parser
+//   parse stage   decodes the chunks the read stage has finished into batches
+//   caller        runs visit() over each batch
+//
+// The stages are joined by SpscRing queues. The read stage stays at most
+// READ_AHEAD_CHUNKS ahead. The parser fills batches from a fixed set that the
+// caller hands back through a second ring, so it stops when every batch is
+// waiting to be simulated. Records reach visit() in trace order, exactly as
+// in the sequential loop.
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+#include "TraceReader.h"
+
+namespace trace_pipeline {
+
+const uint64_t CHUNK_BYTES = 4 << 20;
+const size_t READ_AHEAD_CHUNKS = 8;
+const size_t BATCH_RECORDS = 4096;
+const size_t BATCH_COUNT = 8;
+
+typedef std::vector<TraceRecord> Batch;
+
+// Closes every ring and joins the stages, also when visit() throws
+struct Stages {
+    SpscRing<uint64_t> chunks{READ_AHEAD_CHUNKS};
+    SpscRing<Batch> full{BATCH_COUNT};
+    SpscRing<Batch> empty{BATCH_COUNT};
+    std::thread reader;
+    std::thread parser;
+
+    ~Stages() {
+        chunks.close();
+        full.close();
+        empty.close();
+        if (reader.joinable()) reader.join();
+        if (parser.joinable()) parser.join();
+    }
+};
+
+} // namespace trace_pipeline
+
+// Worth running the stages on their own threads only with a core to spare.
+// Profiled builds decode on the caller's thread (see Profiler.h).
+inline bool usePipelinedReader() {
+#ifdef CACHESIM_PROFILE
+    return false;
+#else
+    return std::thread::hardware_concurrency() >= 2;
+#endif
+}
+
+// Call visit(record) for every request from the reader's current position to
+// its limit with a timestamp in [start_time, end_time]
+template <class Visitor>
+void readPipelined(TraceReader& reader, long long start_time, long long end_time, Visitor&& visit) {
+    using namespace trace_pipeline;
+
+    Stages stages;
+    for (size_t i = 0; i < BATCH_COUNT; i++) {
+        Batch batch;
+        batch.reserve(BATCH_RECORDS);
+        stages.empty.tryPush(batch);
+    }
+
+    // Chunk boundaries are in the units of reader.tell()
+    uint64_t begin = reader.tell();
+    uint64_t limit = reader.getLimit();
+    uint64_t chunk_size = reader.isBinary() ? CHUNK_BYTES / sizeof(BinaryTraceEntry) : CHUNK_BYTES;
+
+    stages.reader = std::thread([&stages, &reader, begin, limit, chunk_size]() {
+        volatile unsigned sink = 0;
+        for (uint64_t from = begin; from < limit; from += chunk_size) {
+            uint64_t to = limit - from > chunk_size ? from + chunk_size : limit;
+            sink = sink + reader.touch(from, to);
+            if (!stages.chunks.push(to)) break;
+        }
+        stages.chunks.close();
+    });
+
+    stages.parser = std::thread([&stages, &reader, start_time, end_time]() {
+        Batch batch;
+        if (!stages.empty.pop(batch)) return;
+        TraceRecord record;
+        uint64_t chunk_end = 0;
+        bool more = true;
+        while (more && stages.chunks.pop(chunk_end)) {
+            // A line that starts in this chunk may end in the next one
+            while (reader.tell() < chunk_end && (more = reader.next(record))) {
+                if (record.timestamp < start_time || record.timestamp > end_time) continue;
+                batch.push_back(record);
+                if (batch.size() < BATCH_RECORDS) continue;
+                if (!stages.full.push(batch) || !stages.empty.pop(batch)) {
+                    stages.chunks.close();
+                    return;
+                }
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) stages.full.push(batch);
+        stages.full.close();
+    });
+
+    Batch batch;
+    while (stages.full.pop(batch)) {
+        for (const TraceRecord& record : batch) visit(record);
+        batch.clear();
+        stages.empty.tryPush(batch);
+    }
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+// Shared trace reader used by all simulators.
+//
+// The trace file is memory-mapped and every line is parsed in place, so no
+// std::string or stream object is created per request. Expected line layout:
+//   Timestamp,Response Time,Offset,Size,Type[,...]
+// where Type is "Read" or "Write". Lines that cannot be parsed are skipped
+// and counted. Files produced by TraceConvert (see BinaryTrace.h) are
+// detected by their header and decoded directly.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TraceRecord.h"
+#include "BinaryTrace.h"
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename) { open(filename); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename) {
+        close();
+#ifdef _WIN32
+        file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size)) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(file_size.QuadPart);
+        if (size_ > 0) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ == nullptr) {
+                close();
+                return false;
+            }
+            data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (data_ == nullptr) {
+                close();
+                return false;
+            }
+        }
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+        }
+        ::close(fd);
+#endif
+        open_ = true;
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mapping_ != nullptr) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+};
+
+namespace trace_parse {
+
+inline void skipSpaces(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+}
+
+// Parse a signed decimal integer, leaving p on the first character after it
+inline bool parseInteger(const char*& p, const char* end, long long& value) {
+    skipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p >= end || *p < '0' || *p > '9') return false;
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    value = negative ? -static_cast<long long>(v) : static_cast<long long>(v);
+    skipSpaces(p, end);
+    return true;
+}
+
+// Move past the next comma on the current line
+inline bool skipField(const char*& p, const char* end) {
+    while (p < end && *p != ',' && *p != '\n') ++p;
+    if (p >= end || *p != ',') return false;
+    ++p;
+    return true;
+}
+
+// Parse a non-negative integer field that may have a fractional part or be
+// empty; value is 0 when there are no leading digits. Leaves p after the comma.
+inline bool parseLenientField(const char*& p, const char* end, uint32_t& value) {
+    skipSpaces(p, end);
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (v <= UINT32_MAX) v = v * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    value = v <= UINT32_MAX ? static_cast<uint32_t>(v) : UINT32_MAX;
+    return skipField(p, end);
+}
+
+inline bool expectComma(const char*& p, const char* end) {
+    if (p >= end || *p != ',') return false;
+    ++p;
+    return true;
+}
+
+inline OpType parseOpType(const char* p, const char* end) {
+    skipSpaces(p, end);
+    const char* field_end = p;
+    while (field_end < end && *field_end != ',' && *field_end != '\n' && *field_end != '\r') ++field_end;
+    size_t len = static_cast<size_t>(field_end - p);
+    if (len == 4 && p[0] == 'R' && p[1] == 'e' && p[2] == 'a' && p[3] == 'd') return OpType::Read;
+    if (len == 5 && p[0] == 'W' && p[1] == 'r' && p[2] == 'i' && p[3] == 't' && p[4] == 'e') return OpType::Write;
+    return OpType::Other;
+}
+
+// Parse one line [begin, end) into a record
+inline bool parseLine(const char* p, const char* end, TraceRecord& record) {
+    long long value;
+    if (!parseInteger(p, end, value) || !expectComma(p, end)) return false;
+    record.timestamp = value;
+    if (!parseLenientField(p, end, record.response_time)) return false;   // Response Time
+    if (!parseInteger(p, end, value) || !expectComma(p, end)) return false;
+    record.offset = value;
+    if (!parseInteger(p, end, value) || !expectComma(p, end)) return false;
+    record.size = static_cast<uint32_t>(value);
+    record.type = parseOpType(p, end);
+    return true;
+}
+
+} // namespace trace_parse
+
+// Where a sequential read stands before a request: TraceReader::tell() and
+// getDecoderState() (or the request's ordinal in a generated workload), and
+// the request's timestamp, which checks that the position still fits the
+// trace
+struct TracePosition {
+    uint64_t position = 0;
+    long long decoder_state = 0;
+    long long timestamp = 0;
+};
+
+// Sequential reader over a memory-mapped CSV or binary trace
+class TraceReader {
+private:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    size_t skipped_lines = 0;
+
+    // Binary format state
+    bool binary = false;
+    const BinaryTraceEntry* entry_cursor = nullptr;
+    const BinaryTraceEntry* entry_end = nullptr;
+    long long last_timestamp = 0;
+    size_t entry_count = 0;
+
+    const BinaryTraceEntry* firstEntry() const {
+        return reinterpret_cast<const BinaryTraceEntry*>(file.data() + sizeof(BinaryTraceHeader));
+    }
+
+    bool nextCsv(TraceRecord& record) {
+        while (cursor < end) {
+            const char* line = cursor;
+            const char* line_end = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+            if (line_end == nullptr) line_end = end;
+            cursor = (line_end < end) ? line_end + 1 : end;
+
+            if (trace_parse::parseLine(line, line_end, record)) return true;
+            skipped_lines++;
+        }
+        return false;
+    }
+
+public:
+    TraceReader() = default;
+    explicit TraceReader(const std::string& filename) { open(filename); }
+
+    bool open(const std::string& filename) {
+        skipped_lines = 0;
+        binary = false;
+        if (!file.open(filename)) {
+            cursor = end = nullptr;
+            return false;
+        }
+        binary = binary_trace::hasMagic(file.data(), file.size());
+        if (binary) {
+            const BinaryTraceHeader* header = reinterpret_cast<const BinaryTraceHeader*>(file.data());
+            if (header->version != BINARY_TRACE_VERSION || header->entry_size != sizeof(BinaryTraceEntry)) {
+                std::cerr << "Error: " << filename << " is binary trace version " << header->version
+                          << "; convert the CSV again with TraceConvert" << std::endl;
+                file.close();
+                return false;
+            }
+            size_t available = (file.size() - sizeof(BinaryTraceHeader)) / sizeof(BinaryTraceEntry);
+            entry_count = header->entry_count < available ? static_cast<size_t>(header->entry_count) : available;
+        }
+        rewind();
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+    bool isBinary() const { return binary; }
+
+    // Decode the next request; returns false at end of file
+    bool next(TraceRecord& record) {
+        if (binary) return binary_trace::decodeNext(entry_cursor, entry_end, last_timestamp, record);
+        return nextCsv(record);
+    }
+
+    // Restart from the beginning of the file and clear any limit
+    void rewind() {
+        skipped_lines = 0;
+        if (binary) {
+            const BinaryTraceHeader* header = reinterpret_cast<const BinaryTraceHeader*>(file.data());
+            entry_cursor = firstEntry();
+            entry_end = firstEntry() + entry_count;
+            last_timestamp = header->first_timestamp;
+        } else {
+            cursor = file.data();
+            end = file.data() + file.size();
+        }
+    }
+
+    // Position of the next record: a byte offset for CSV, an entry index for binary
+    uint64_t tell() const {
+        if (binary) return static_cast<uint64_t>(entry_cursor - firstEntry());
+        return static_cast<uint64_t>(cursor - file.data());
+    }
+
+    // Decoder state that must be restored together with a position
+    long long getDecoderState() const { return binary ? last_timestamp : 0; }
+
+    // Continue reading from a position previously returned by tell()
+    void seek(uint64_t position, long long decoder_state) {
+        if (binary) {
+            entry_cursor = firstEntry() + position;
+            if (entry_cursor > entry_end) entry_cursor = entry_end;
+            last_timestamp = decoder_state;
+        } else {
+            cursor = file.data() + (position < file.size() ? position : file.size());
+            if (cursor > end) cursor = end;
+        }
+    }
+
+    // Stop reading at a position previously returned by tell()
+    void setLimit(uint64_t position) {
+        if (binary) {
+            const BinaryTraceEntry* limit = firstEntry() + position;
+            if (limit < entry_end) entry_end = limit;
+        } else {
+            const char* limit = file.data() + position;
+            if (limit < end) end = limit;
+        }
+    }
+
+    // Position where reading stops, in the units of tell()
+    uint64_t getLimit() const {
+        if (binary) return static_cast<uint64_t>(entry_end - firstEntry());
+        return static_cast<uint64_t>(end - file.data());
+    }
+
+    // Fault in the pages holding positions [from, to) so a later next() does
+    // not wait on the disk. Only reads the mapping, so it may run on another
+    // thread while this reader decodes. Returns a sum of the bytes touched,
+    // which keeps the reads from being optimized away.
+    unsigned touch(uint64_t from, uint64_t to) const {
+        const uint64_t PAGE = 4096;
+        uint64_t scale = binary ? sizeof(BinaryTraceEntry) : 1;
+        uint64_t base = binary ? sizeof(BinaryTraceHeader) : 0;
+        uint64_t first = base + from * scale;
+        uint64_t last = base + to * scale;
+        if (last > file.size()) last = file.size();
+        unsigned sum = 0;
+        for (uint64_t byte = first; byte < last; byte += PAGE) {
+            sum += static_cast<unsigned char>(file.data()[byte]);
+        }
+        return sum;
+    }
+
+    size_t getSkippedLines() const { return skipped_lines; }
+};
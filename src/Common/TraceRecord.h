@@ -0,0 +1,20 @@
+#pragma once
+
+// Decoded request shared by every trace format and simulator
+
+#include <cstdint>
+
+enum class OpType : uint8_t {
+    Read = 0,
+    Write = 1,
+    Other = 2
+};
+
+// Compact decoded request
+struct TraceRecord {
+    long long timestamp;
+    long long offset;
+    uint32_t size;
+    OpType type;
+    uint32_t response_time;   // As recorded in the trace; 0 if absent
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+// Synthetic workloads generated in memory.
+//
+// A workload is named by a spec string that can be given anywhere a trace
+// path is expected:
+//     gen:<pattern>[:key=value]...
+// for example gen:zipf:keys=1000000:skew=0.99:requests=1000000000. Patterns:
+//   zipf    Zipf(skew) popularity over `keys` offsets
+//   scan    one pass over new offsets, never repeating
+//   loop    cycles over `keys` offsets in order
+//   hotset  `hot_share` of requests go uniformly to `hot_keys` offsets, the
+//           rest uniformly to all `keys`; the hot set moves to the next
+//           `hot_keys` offsets every `shift_every` requests
+// Other keys: requests, reads (read fraction), size (bytes, or a range a-b in
+// 512-byte steps), stride (bytes between offsets), interarrival (ns between
+// requests), response (recorded response time) and seed. The same spec and
+// seed produce the same requests on every platform.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "TraceRecord.h"
+
+const char WORKLOAD_PREFIX[] = "gen:";
+
+enum class WorkloadPattern {
+    Zipf,
+    Scan,
+    Loop,
+    HotSet
+};
+
+struct WorkloadSpec {
+    WorkloadPattern pattern = WorkloadPattern::Zipf;
+    long long requests = 1000000;
+    long long keys = 100000;           // Distinct offsets (zipf, loop, hotset)
+    double skew = 0.9;                 // zipf
+    long long hot_keys = 1000;         // hotset
+    double hot_share = 0.9;            // hotset
+    long long shift_every = 100000;    // hotset; 0 keeps the hot set in place
+    double read_fraction = 0.7;
+    uint32_t min_size = 4096;
+    uint32_t max_size = 4096;
+    long long stride = 4096;
+    long long interarrival = 1000;
+    uint32_t response_time = 0;
+    uint64_t seed = 1;
+};
+
+inline bool isWorkloadName(const std::string& name) {
+    return name.compare(0, sizeof(WORKLOAD_PREFIX) - 1, WORKLOAD_PREFIX) == 0;
+}
+
+namespace workload_detail {
+
+inline bool parseCount(const std::string& text, long long& value) {
+    char* end = nullptr;
+    value = strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && value >= 0;
+}
+
+inline bool parseFraction(const std::string& text, double& value) {
+    char* end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && value >= 0;
+}
+
+// x * y mod m without overflow, for x, y < m
+inline uint64_t mulMod(uint64_t x, uint64_t y, uint64_t m) {
+    if (m <= (1ULL << 32)) return (x * y) % m;
+    uint64_t result = 0;
+    x %= m;
+    while (y > 0) {
+        if (y & 1) result = (result >= m - x) ? result - (m - x) : result + x;
+        x = (x >= m - x) ? x - (m - x) : x + x;
+        y >>= 1;
+    }
+    return result;
+}
+
+// xoshiro256**, seeded through splitmix64
+class Random {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    explicit Random(uint64_t seed) {
+        for (uint64_t& s : state) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Uniform in [0, bound), without modulo bias
+    uint64_t below(uint64_t bound) {
+        uint64_t limit = UINT64_MAX - UINT64_MAX % bound;
+        uint64_t value;
+        do {
+            value = next();
+        } while (value >= limit);
+        return value % bound;
+    }
+};
+
+// Zipf ranks in [1, n] by rejection-inversion (Hoermann and Derflinger,
+// 1996): constant time and memory per sample for any n and any skew > 0
+class ZipfSampler {
+private:
+    long long n = 1;
+    double exponent = 1;
+    double h_integral_x1 = 0;
+    double h_integral_n = 0;
+    double s = 0;
+
+    // log1p(x) / x and expm1(x) / x, accurate near 0
+    static double helper1(double x) { return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x)); }
+    static double helper2(double x) { return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x)); }
+
+    double h(double x) const { return std::exp(-exponent * std::log(x)); }
+
+    double hIntegral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1 - exponent) * log_x) * log_x;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = x * (1 - exponent);
+        if (t < -1) t = -1;
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    ZipfSampler() = default;
+    ZipfSampler(long long count, double skew) : n(count), exponent(skew) {
+        h_integral_x1 = hIntegral(1.5) - 1;
+        h_integral_n = hIntegral(n + 0.5);
+        s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    long long sample(Random& random) const {
+        while (true) {
+            double u = h_integral_n + random.uniform() * (h_integral_x1 - h_integral_n);
+            double x = hIntegralInverse(u);
+            long long k = static_cast<long long>(x + 0.5);
+            if (k < 1) k = 1;
+            else if (k > n) k = n;
+            if (k - x <= s || u >= hIntegral(k + 0.5) - h(static_cast<double>(k))) return k;
+        }
+    }
+};
+
+} // namespace workload_detail
+
+// Parse a "gen:..." spec; on failure returns false and describes the problem in error
+inline bool parseWorkloadSpec(const std::string& name, WorkloadSpec& spec, std::string& error) {
+    using namespace workload_detail;
+
+    if (!isWorkloadName(name)) {
+        error = "workload specs start with " + std::string(WORKLOAD_PREFIX);
+        return false;
+    }
+    std::string rest = name.substr(sizeof(WORKLOAD_PREFIX) - 1);
+    size_t colon = rest.find(':');
+    std::string pattern = rest.substr(0, colon);
+    if (pattern == "zipf") spec.pattern = WorkloadPattern::Zipf;
+    else if (pattern == "scan") spec.pattern = WorkloadPattern::Scan;
+    else if (pattern == "loop") spec.pattern = WorkloadPattern::Loop;
+    else if (pattern == "hotset") spec.pattern = WorkloadPattern::HotSet;
+    else {
+        error = "unknown workload pattern '" + pattern + "'";
+        return false;
+    }
+
+    while (colon != std::string::npos) {
+        size_t start = colon + 1;
+        colon = rest.find(':', start);
+        std::string field = rest.substr(start, colon == std::string::npos ? std::string::npos : colon - start);
+        size_t equals = field.find('=');
+        if (equals == std::string::npos) {
+            error = "expected key=value, got '" + field + "'";
+            return false;
+        }
+        std::string key = field.substr(0, equals);
+        std::string value = field.substr(equals + 1);
+
+        long long count = 0;
+        bool ok = true;
+        if (key == "requests") ok = parseCount(value, spec.requests);
+        else if (key == "keys") ok = parseCount(value, spec.keys) && spec.keys > 0;
+        else if (key == "skew") ok = parseFraction(value, spec.skew) && spec.skew > 0;
+        else if (key == "hot_keys") ok = parseCount(value, spec.hot_keys) && spec.hot_keys > 0;
+        else if (key == "hot_share") ok = parseFraction(value, spec.hot_share) && spec.hot_share <= 1;
+        else if (key == "shift_every") ok = parseCount(value, spec.shift_every);
+        else if (key == "reads") ok = parseFraction(value, spec.read_fraction) && spec.read_fraction <= 1;
+        else if (key == "stride") ok = parseCount(value, spec.stride) && spec.stride > 0;
+        else if (key == "interarrival") ok = parseCount(value, spec.interarrival);
+        else if (key == "response") {
+            ok = parseCount(value, count) && count <= UINT32_MAX;
+            spec.response_time = static_cast<uint32_t>(count);
+        } else if (key == "seed") {
+            ok = parseCount(value, count);
+            spec.seed = static_cast<uint64_t>(count);
+        } else if (key == "size") {
+            size_t dash = value.find('-');
+            long long low = 0, high = 0;
+            ok = parseCount(value.substr(0, dash), low) &&
+                 parseCount(dash == std::string::npos ? value : value.substr(dash + 1), high) &&
+                 low > 0 && low <= high && high <= UINT32_MAX;
+            spec.min_size = static_cast<uint32_t>(low);
+            spec.max_size = static_cast<uint32_t>(high);
+        } else {
+            error = "unknown workload key '" + key + "'";
+            return false;
+        }
+        if (!ok) {
+            error = "invalid value for " + key + ": '" + value + "'";
+            return false;
+        }
+    }
+    if (spec.pattern == WorkloadPattern::HotSet && spec.hot_keys > spec.keys) {
+        error = "hot_keys must not exceed keys";
+        return false;
+    }
+    return true;
+}
+
+// Streams the requests of a spec; next() returns false after the last one
+class WorkloadGenerator {
+private:
+    WorkloadSpec spec;
+    workload_detail::Random random;
+    workload_detail::ZipfSampler zipf;
+    long long produced = 0;
+
+    static const uint32_t SIZE_STEP = 512;
+
+    long long nextKey() {
+        switch (spec.pattern) {
+            case WorkloadPattern::Zipf: {
+                // Scatter ranks over the key space so popular offsets are not adjacent;
+                // multiplying by a prime is a bijection unless keys is a multiple of it
+                uint64_t rank = static_cast<uint64_t>(zipf.sample(random) - 1);
+                uint64_t keys = static_cast<uint64_t>(spec.keys);
+                return static_cast<long long>(keys % 2654435761ULL == 0 ? rank : workload_detail::mulMod(rank, 2654435761ULL % keys, keys));
+            }
+            case WorkloadPattern::Scan:
+                return produced;
+            case WorkloadPattern::Loop:
+                return produced % spec.keys;
+            case WorkloadPattern::HotSet: {
+                if (random.uniform() >= spec.hot_share) {
+                    return static_cast<long long>(random.below(static_cast<uint64_t>(spec.keys)));
+                }
+                long long phase = spec.shift_every > 0 ? produced / spec.shift_every : 0;
+                long long base = static_cast<long long>(workload_detail::mulMod(static_cast<uint64_t>(phase % spec.keys),
+                                                                                 static_cast<uint64_t>(spec.hot_keys),
+                                                                                 static_cast<uint64_t>(spec.keys)));
+                return (base + static_cast<long long>(random.below(static_cast<uint64_t>(spec.hot_keys)))) % spec.keys;
+            }
+        }
+        return 0;
+    }
+
+public:
+    explicit WorkloadGenerator(const WorkloadSpec& workload) : spec(workload), random(workload.seed) {
+        if (spec.pattern == WorkloadPattern::Zipf) zipf = workload_detail::ZipfSampler(spec.keys, spec.skew);
+    }
+
+    bool next(TraceRecord& record) {
+        if (produced >= spec.requests) return false;
+        record.timestamp = produced * spec.interarrival;
+        record.offset = nextKey() * spec.stride;
+        record.size = spec.min_size;
+        if (spec.max_size > spec.min_size) {
+            uint64_t steps = (spec.max_size - spec.min_size) / SIZE_STEP + 1;
+            record.size += static_cast<uint32_t>(random.below(steps)) * SIZE_STEP;
+        }
+        record.type = random.uniform() < spec.read_fraction ? OpType::Read : OpType::Write;
+        record.response_time = spec.response_time;
+        produced++;
+        return true;
+    }
+
+    long long getProduced() const { return produced; }
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+// Runs many policy instances over one read of a trace.
+//
+// The calling thread decodes the window once into fixed-size batches and
+// publishes each batch to every worker. Each worker owns a disjoint set of
+// policy instances and feeds every batch to all of them, so the trace is
+// parsed once regardless of how many policies and capacities are compared.
+
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Arc/ARC_Cache.h"
+#include "../Arc/LARC_Cache.h"
+#include "../LRU/LRU_Cache.h"
+#include "../N-hit/NHitCache.h"
+#include "../Oracle/BeladyCache.h"
+#include "../Common/CostModel.h"
+#include "../Common/Simulation.h"
+#include "../Common/SizeList.h"
+
+const size_t SIMULATION_BATCH_SIZE = 1 << 16;
+
+// One policy instance with its own statistics
+class SimulationJob {
+protected:
+    CacheStats stats;
+    CostStats costs;
+
+public:
+    std::string policy_name;
+    size_t capacity = 0;
+    double estimated_cost = 1.0;   // Relative per-request cost, used to balance workers
+    const CostModel* cost_model = nullptr;   // Latency is tracked only when set
+
+    virtual ~SimulationJob() = default;
+    virtual void runBatch(const TraceRecord* begin, const TraceRecord* end) = 0;
+
+    CacheStats& getStats() { return stats; }
+    const CacheStats& getStats() const { return stats; }
+    const CostStats& getCosts() const { return costs; }
+};
+
+template <class Policy>
+class PolicyJob : public SimulationJob {
+private:
+    Policy policy;
+
+public:
+    template <class... Args>
+    PolicyJob(size_t cap, double cost, Args&&... args) : policy(std::forward<Args>(args)...) {
+        policy_name = Policy::name();
+        capacity = cap;
+        estimated_cost = cost;
+    }
+
+    void runBatch(const TraceRecord* begin, const TraceRecord* end) override {
+        if (cost_model == nullptr) {
+            for (const TraceRecord* record = begin; record != end; ++record) {
+                simulateRequest(policy, *record, stats, nullptr);
+            }
+            return;
+        }
+        for (const TraceRecord* record = begin; record != end; ++record) {
+            bool hit = policy.access(record->offset, record->type);
+            stats.record(hit, record->type);
+            costs.record(hit, *record, *cost_model);
+        }
+    }
+};
+
+struct PolicyParameters {
+    int insertion_threshold = 2;   // N-hit
+    int piece_count = 1;           // Belady
+    size_t sketch_budget_kb = 1024;  // N-hit with count-min sketch admission
+};
+
+// Relative per-request cost of a policy, used to order and balance jobs
+inline double estimatedPolicyCost(const std::string& policy, const PolicyParameters& params) {
+    if (policy == "ARC" || policy == "LARC") return 1.5;
+    if (policy == "NHIT" || policy == "NHITCMS") return 2.0;
+    if (policy == "BELADY" && params.piece_count > 1) return 4.0;
+    return 1.0;
+}
+
+// Create a job for a policy name (ARC, LARC, LRU, NHIT, NHITCMS, BELADY).
+// Belady needs the whole window in `sequence`; returns nullptr if the name is unknown.
+// capacity must be at most MAX_CACHE_SIZE (see SizeList.h).
+inline std::unique_ptr<SimulationJob> makeSimulationJob(const std::string& policy, size_t capacity,
+                                                        const PolicyParameters& params,
+                                                        const std::vector<TraceRecord>* sequence) {
+    double cost = estimatedPolicyCost(policy, params);
+    if (policy == "ARC") return std::unique_ptr<SimulationJob>(new PolicyJob<ARC_Cache>(capacity, cost, capacity));
+    if (policy == "LARC") return std::unique_ptr<SimulationJob>(new PolicyJob<LARC_Cache>(capacity, cost, capacity));
+    if (policy == "LRU") return std::unique_ptr<SimulationJob>(new PolicyJob<LRU_Cache>(capacity, cost, capacity));
+    if (policy == "NHIT") {
+        return std::unique_ptr<SimulationJob>(new PolicyJob<NHitCache>(capacity, cost, static_cast<int>(capacity),
+                                                                       params.insertion_threshold));
+    }
+    if (policy == "NHITCMS") {
+        return std::unique_ptr<SimulationJob>(new PolicyJob<SketchNHitCache>(capacity, cost, static_cast<int>(capacity),
+                                                                             params.insertion_threshold,
+                                                                             params.sketch_budget_kb * 1024));
+    }
+    if (policy == "BELADY" && sequence != nullptr && params.piece_count <= 1) {
+        return std::unique_ptr<SimulationJob>(new PolicyJob<ExactBeladyCache>(capacity, cost, static_cast<int>(capacity),
+                                                                              *sequence));
+    }
+    if (policy == "BELADY" && sequence != nullptr) {
+        return std::unique_ptr<SimulationJob>(new PolicyJob<BeladyCache>(capacity, cost, static_cast<int>(capacity),
+                                                                         params.piece_count, *sequence));
+    }
+    return nullptr;
+}
+
+// A slice of decoded requests kept alive by its storage
+struct TraceBatch {
+    std::shared_ptr<const std::vector<TraceRecord> > storage;
+    const TraceRecord* begin = nullptr;
+    const TraceRecord* end = nullptr;
+};
+
+// Bounded queue where every batch is delivered to all consumers
+class BatchBroadcast {
+private:
+    struct Slot {
+        TraceBatch batch;
+        int pending = 0;
+    };
+
+    std::vector<Slot> slots;
+    int consumers;
+    size_t published = 0;
+    bool finished = false;
+    std::mutex mutex;
+    std::condition_variable batch_ready;
+    std::condition_variable slot_free;
+
+public:
+    BatchBroadcast(size_t depth, int consumer_count) : slots(depth), consumers(consumer_count) {}
+
+    // Blocks while the oldest slot is still being consumed
+    void publish(const TraceBatch& batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        Slot& slot = slots[published % slots.size()];
+        slot_free.wait(lock, [&] { return slot.pending == 0; });
+        slot.batch = batch;
+        slot.pending = consumers;
+        published++;
+        batch_ready.notify_all();
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        batch_ready.notify_all();
+    }
+
+    // Wait for batch number `index`; returns false once all batches are consumed
+    bool acquire(size_t index, TraceBatch& batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        batch_ready.wait(lock, [&] { return index < published || finished; });
+        if (index >= published) return false;
+        batch = slots[index % slots.size()].batch;
+        return true;
+    }
+
+    void release(size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& slot = slots[index % slots.size()];
+        if (--slot.pending == 0) {
+            slot.batch = TraceBatch();
+            slot_free.notify_one();
+        }
+    }
+};
+
+// Run every job over the window of the trace using up to thread_count workers.
+// If sequence is non-null it must already hold the window and is used instead
+// of reading the file. Returns the number of cold misses (first references),
+// which is the same for every policy, or -1 if the trace could not be read.
+inline long long runJobsInParallel(const std::string& filename, const TimeWindow& window,
+                                   const std::vector<TraceRecord>* sequence,
+                                   std::vector<std::unique_ptr<SimulationJob> >& jobs,
+                                   unsigned thread_count) {
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = std::min<unsigned>(thread_count, static_cast<unsigned>(std::max<size_t>(jobs.size(), 1)));
+
+    // Longest-processing-time-first assignment of jobs to workers
+    std::vector<SimulationJob*> order;
+    for (auto& job : jobs) order.push_back(job.get());
+    std::sort(order.begin(), order.end(), [](const SimulationJob* a, const SimulationJob* b) {
+        return a->estimated_cost > b->estimated_cost;
+    });
+    std::vector<std::vector<SimulationJob*> > assignment(thread_count);
+    std::vector<double> load(thread_count, 0.0);
+    for (SimulationJob* job : order) {
+        size_t worker = std::min_element(load.begin(), load.end()) - load.begin();
+        assignment[worker].push_back(job);
+        load[worker] += job->estimated_cost;
+    }
+
+    BatchBroadcast broadcast(8, static_cast<int>(thread_count));
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < thread_count; w++) {
+        workers.emplace_back([&broadcast, &assignment, w] {
+            TraceBatch batch;
+            for (size_t index = 0; broadcast.acquire(index, batch); index++) {
+                for (SimulationJob* job : assignment[w]) {
+                    job->runBatch(batch.begin, batch.end);
+                }
+                broadcast.release(index);
+            }
+        });
+    }
+
+    long long cold_misses = 0;
+    ColdMissTracker cold_tracker;
+    bool ok = true;
+
+    if (sequence != nullptr) {
+        for (size_t i = 0; i < sequence->size(); i += SIMULATION_BATCH_SIZE) {
+            TraceBatch batch;
+            batch.begin = sequence->data() + i;
+            batch.end = sequence->data() + std::min(i + SIMULATION_BATCH_SIZE, sequence->size());
+            for (const TraceRecord* r = batch.begin; r != batch.end; ++r) {
+                if (cold_tracker.firstReference(r->offset)) cold_misses++;
+            }
+            broadcast.publish(batch);
+        }
+    } else {
+        std::shared_ptr<std::vector<TraceRecord> > storage;
+        auto publish = [&]() {
+            TraceBatch batch;
+            batch.begin = storage->data();
+            batch.end = storage->data() + storage->size();
+            batch.storage = storage;
+            broadcast.publish(batch);
+            storage.reset();
+        };
+        ok = forEachRequest(filename, window, [&](const TraceRecord& record) {
+            if (!storage) {
+                storage = std::make_shared<std::vector<TraceRecord> >();
+                storage->reserve(SIMULATION_BATCH_SIZE);
+            }
+            if (cold_tracker.firstReference(record.offset)) cold_misses++;
+            storage->push_back(record);
+            if (storage->size() == SIMULATION_BATCH_SIZE) publish();
+        });
+        if (storage) publish();
+    }
+
+    broadcast.finish();
+    for (std::thread& worker : workers) worker.join();
+
+    for (auto& job : jobs) job->getStats().cold_misses = cold_misses;
+    return ok ? cold_misses : -1;
+}
+
+inline void printComparisonTable(const std::vector<std::unique_ptr<SimulationJob> >& jobs) {
+    std::cout << std::left << std::setw(10) << "Policy" << std::right
+              << std::setw(12) << "Capacity" << std::setw(12) << "Requests"
+              << std::setw(12) << "Hits" << std::setw(12) << "Misses"
+              << std::setw(12) << "Cold" << std::setw(12) << "ReadHits"
+              << std::setw(12) << "WriteHits" << std::setw(10) << "HitRate" << std::endl;
+    for (const auto& job : jobs) {
+        const CacheStats& s = job->getStats();
+        std::cout << std::left << std::setw(10) << job->policy_name << std::right
+                  << std::setw(12) << job->capacity << std::setw(12) << s.total_requests
+                  << std::setw(12) << s.total_hits << std::setw(12) << s.total_misses
+                  << std::setw(12) << s.cold_misses << std::setw(12) << s.total_read_hits
+                  << std::setw(12) << s.total_write_hits
+                  << std::setw(9) << std::fixed << std::setprecision(2) << s.hitRate() << "%"
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+// Latency under each job's policy; the first row is the trace as recorded,
+// with every request served by the device
+inline void printCostTable(const std::vector<std::unique_ptr<SimulationJob> >& jobs) {
+    std::cout << std::left << std::setw(10) << "Policy" << std::right << std::setw(12) << "Capacity"
+              << std::setw(10) << "HitRate" << std::setw(10) << "ByteHit" << std::setw(12) << "MeanLat"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p999"
+              << std::setw(12) << "ByteWtLat" << std::setw(10) << "Saved" << std::setw(12) << "ByteSaved"
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    if (!jobs.empty()) {
+        const CostStats& c = jobs.front()->getCosts();
+        std::cout << std::left << std::setw(10) << "Device" << std::right << std::setw(12) << "-"
+                  << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(12) << c.meanDeviceLatency()
+                  << std::setw(10) << c.device_latency.percentile(0.5)
+                  << std::setw(10) << c.device_latency.percentile(0.99)
+                  << std::setw(10) << c.device_latency.percentile(0.999)
+                  << std::setw(12) << c.byteWeightedDeviceLatency() << std::setw(10) << "-" << std::setw(12) << "-"
+                  << std::endl;
+    }
+    for (const auto& job : jobs) {
+        const CacheStats& s = job->getStats();
+        const CostStats& c = job->getCosts();
+        std::cout << std::left << std::setw(10) << job->policy_name << std::right << std::setw(12) << job->capacity
+                  << std::setw(9) << s.hitRate() << "%" << std::setw(9) << c.byteHitRate() << "%"
+                  << std::setw(12) << c.meanLatency() << std::setw(10) << c.latency.percentile(0.5)
+                  << std::setw(10) << c.latency.percentile(0.99) << std::setw(10) << c.latency.percentile(0.999)
+                  << std::setw(12) << c.byteWeightedLatency() << std::setw(9) << c.savedPercent() << "%"
+                  << std::setw(11) << c.byteWeightedSavedPercent() << "%" << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+// Hash-partitioned cache simulation.
+//
+// The cache is split into shards, as in a sharded production cache. Each
+// shard has its own policy instance and capacity, and the calling thread
+// routes every request to shard shardOf(offset). Each shard runs on its own
+// worker thread and is fed batches of its requests through its own
+// SpscRing, so shards share no state. An offset always goes to the same
+// shard, so the results do not depend on thread timing and equal those of
+// running each shard's requests alone.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Common/Simulation.h"
+#include "../Common/SpscRing.h"
+#include "MultiSimulation.h"
+
+namespace sharding {
+
+const size_t BATCH_RECORDS = 4096;
+const size_t BATCH_COUNT = 8;
+
+typedef std::vector<TraceRecord> Batch;
+
+// splitmix64 finalizer, so page-aligned offsets spread over all shards
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace sharding
+
+inline size_t shardOf(long long offset, size_t shard_count) {
+    return static_cast<size_t>(sharding::mix(static_cast<uint64_t>(offset)) % shard_count);
+}
+
+class ShardedSimulation {
+private:
+    struct Shard {
+        std::unique_ptr<SimulationJob> job;
+        SpscRing<sharding::Batch> full{sharding::BATCH_COUNT};
+        SpscRing<sharding::Batch> empty{sharding::BATCH_COUNT};
+        sharding::Batch filling;    // Being filled by the router
+        double busy_seconds = 0;    // Written by the worker, read after join
+        std::thread worker;
+    };
+
+    std::vector<std::unique_ptr<Shard> > shards;
+
+    void stop() {
+        for (auto& shard : shards) {
+            shard->full.close();
+            shard->empty.close();
+        }
+        for (auto& shard : shards) {
+            if (shard->worker.joinable()) shard->worker.join();
+        }
+    }
+
+    // Hand the shard's full batch to its worker and take back an empty one
+    static void dispatch(Shard& shard) {
+        if (!shard.full.push(shard.filling) || !shard.empty.pop(shard.filling)) shard.filling = sharding::Batch();
+        shard.filling.clear();
+    }
+
+public:
+    // One job per shard; all of them should have the same policy and capacity
+    explicit ShardedSimulation(std::vector<std::unique_ptr<SimulationJob> > jobs) {
+        for (auto& job : jobs) {
+            shards.emplace_back(new Shard());
+            shards.back()->job = std::move(job);
+        }
+    }
+
+    ~ShardedSimulation() { stop(); }
+
+    ShardedSimulation(const ShardedSimulation&) = delete;
+    ShardedSimulation& operator=(const ShardedSimulation&) = delete;
+
+    size_t shardCount() const { return shards.size(); }
+    const SimulationJob& getJob(size_t shard) const { return *shards[shard]->job; }
+
+    // Seconds the shard's worker spent simulating
+    double getBusySeconds(size_t shard) const { return shards[shard]->busy_seconds; }
+
+    // Route the window of the trace through the shards. Cold misses are
+    // counted by the router, as each offset has one shard. Returns false if
+    // the trace could not be read.
+    bool run(const std::string& filename, const TimeWindow& window) {
+        using namespace sharding;
+
+        for (auto& owned : shards) {
+            Shard* shard = owned.get();
+            shard->filling.reserve(BATCH_RECORDS);
+            for (size_t i = 1; i < BATCH_COUNT; i++) {
+                Batch batch;
+                batch.reserve(BATCH_RECORDS);
+                shard->empty.tryPush(batch);
+            }
+            shard->worker = std::thread([shard]() {
+                Batch batch;
+                while (shard->full.pop(batch)) {
+                    auto started = std::chrono::steady_clock::now();
+                    shard->job->runBatch(batch.data(), batch.data() + batch.size());
+                    shard->busy_seconds +=
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+                    batch.clear();
+                    shard->empty.tryPush(batch);
+                }
+            });
+        }
+
+        ColdMissTracker cold_tracker;
+        std::vector<long long> cold_misses(shards.size(), 0);
+        bool ok = forEachRequest(filename, window, [&](const TraceRecord& record) {
+            size_t s = shardOf(record.offset, shards.size());
+            if (cold_tracker.firstReference(record.offset)) cold_misses[s]++;
+            Shard& shard = *shards[s];
+            shard.filling.push_back(record);
+            if (shard.filling.size() == BATCH_RECORDS) dispatch(shard);
+        });
+
+        for (auto& shard : shards) {
+            if (!shard->filling.empty()) shard->full.push(shard->filling);
+            shard->full.close();
+        }
+        for (auto& shard : shards) shard->worker.join();
+        for (size_t s = 0; s < shards.size(); s++) shards[s]->job->getStats().cold_misses = cold_misses[s];
+        return ok;
+    }
+};
+
+// Load imbalance of a per-shard quantity: max/mean and the coefficient of
+// variation (standard deviation over mean); both are 1 and 0 when balanced
+struct Imbalance {
+    double max_over_mean = 0;
+    double coefficient_of_variation = 0;
+};
+
+inline Imbalance imbalanceOf(const std::vector<double>& values) {
+    Imbalance result;
+    if (values.empty()) return result;
+    double sum = 0, max_value = 0;
+    for (double value : values) {
+        sum += value;
+        max_value = std::max(max_value, value);
+    }
+    double mean = sum / values.size();
+    if (mean <= 0) return result;
+    double variance = 0;
+    for (double value : values) variance += (value - mean) * (value - mean);
+    result.max_over_mean = max_value / mean;
+    result.coefficient_of_variation = std::sqrt(variance / values.size()) / mean;
+    return result;
+}
+
+// One row per shard, the aggregate, and the imbalance of requests, misses
+// and worker time across shards
+inline void printShardTable(const ShardedSimulation& simulation) {
+    std::cout << std::left << std::setw(8) << "Shard" << std::right << std::setw(12) << "Requests"
+              << std::setw(9) << "Share" << std::setw(12) << "Hits" << std::setw(12) << "Misses"
+              << std::setw(12) << "Cold" << std::setw(12) << "ReadHits" << std::setw(12) << "WriteHits"
+              << std::setw(10) << "HitRate" << std::setw(10) << "Busy(s)" << std::endl;
+
+    CacheStats total;
+    std::vector<double> requests, misses, busy;
+    for (size_t s = 0; s < simulation.shardCount(); s++) {
+        const CacheStats& stats = simulation.getJob(s).getStats();
+        total.total_requests += stats.total_requests;
+        total.total_hits += stats.total_hits;
+        total.total_misses += stats.total_misses;
+        total.cold_misses += stats.cold_misses;
+        total.total_read_hits += stats.total_read_hits;
+        total.total_write_hits += stats.total_write_hits;
+        requests.push_back(static_cast<double>(stats.total_requests));
+        misses.push_back(static_cast<double>(stats.total_misses));
+        busy.push_back(simulation.getBusySeconds(s));
+    }
+
+    auto row = [&](const std::string& label, const CacheStats& stats, double busy_seconds) {
+        double share = total.total_requests > 0 ? 100.0 * stats.total_requests / total.total_requests : 0;
+        std::cout << std::left << std::setw(8) << label << std::right << std::setw(12) << stats.total_requests
+                  << std::fixed << std::setprecision(2) << std::setw(8) << share << "%"
+                  << std::setw(12) << stats.total_hits << std::setw(12) << stats.total_misses
+                  << std::setw(12) << stats.cold_misses << std::setw(12) << stats.total_read_hits
+                  << std::setw(12) << stats.total_write_hits << std::setw(9) << stats.hitRate() << "%"
+                  << std::setprecision(3) << std::setw(10) << busy_seconds << std::defaultfloat << std::endl;
+    };
+    double total_busy = 0;
+    for (size_t s = 0; s < simulation.shardCount(); s++) {
+        row(std::to_string(s), simulation.getJob(s).getStats(), busy[s]);
+        total_busy += busy[s];
+    }
+    row("All", total, total_busy);
+
+    std::cout << std::endl << std::left << std::setw(12) << "Imbalance" << std::right << std::setw(12)
+              << "Max/Mean" << std::setw(12) << "CoV" << std::endl;
+    auto imbalance_row = [](const char* label, const std::vector<double>& values) {
+        Imbalance imbalance = imbalanceOf(values);
+        std::cout << std::left << std::setw(12) << label << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << imbalance.max_over_mean << std::setw(12)
+                  << imbalance.coefficient_of_variation << std::defaultfloat << std::endl;
+    };
+    imbalance_row("Requests", requests);
+    imbalance_row("Misses", misses);
+    imbalance_row("Busy time", busy);
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+// SHARDS: miss-ratio curves from a spatially hashed sample of the trace.
+//
+// An offset is sampled when hash(offset) mod P is below a threshold T, so the
+// sampling rate is R = T / P and every request to a sampled offset is kept.
+// Stack distances measured on the sample are scaled by 1/R and each sampled
+// request stands for 1/R requests of the full trace.
+//
+// With a sample limit the analyzer keeps at most that many sampled offsets:
+// when the limit is exceeded the offsets with the largest hash values are
+// dropped and T is lowered to their hash, so memory stays fixed while the
+// rate adapts to the trace. Requests sampled earlier keep the weight of the
+// rate in force when they were seen.
+//
+// Policies that are not stack algorithms (ARC) are estimated by miniature
+// simulation instead: the sampled stream is fed to a cache of C * R entries.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "../Arc/ARC_Cache.h"
+#include "../Common/CacheStats.h"
+#include "../LRU/StackDistance.h"
+
+const uint64_t SHARDS_MODULUS = 1ULL << 24;
+
+// 64-bit finalizer (MurmurHash3) reduced to [0, SHARDS_MODULUS)
+inline uint64_t shardsHash(long long offset) {
+    uint64_t h = static_cast<uint64_t>(offset);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h & (SHARDS_MODULUS - 1);
+}
+
+// Weighted hit counts of the requested capacities, for one operation type
+class WeightedCurve {
+private:
+    std::vector<size_t> sorted_capacities;
+    std::vector<double> hits;    // hits[i]: weight of requests with scaled distance in (c[i-1], c[i]]
+    double total = 0;
+
+public:
+    explicit WeightedCurve(const std::vector<size_t>& capacities)
+        : sorted_capacities(capacities), hits(capacities.size(), 0.0) {
+        std::sort(sorted_capacities.begin(), sorted_capacities.end());
+    }
+
+    void addRequest(double weight) { total += weight; }
+
+    // A hit for every capacity of at least `distance`
+    void addHit(double distance, double weight) {
+        size_t i = std::lower_bound(sorted_capacities.begin(), sorted_capacities.end(),
+                                    static_cast<size_t>(std::ceil(distance))) - sorted_capacities.begin();
+        if (i < hits.size()) hits[i] += weight;
+    }
+
+    double getTotal() const { return total; }
+
+    // Estimated hits of each capacity, clamped to [0, requests]
+    std::vector<double> hitsForCapacities(const std::vector<size_t>& capacities, double requests) const {
+        std::vector<double> result;
+        for (size_t capacity : capacities) {
+            size_t last = std::upper_bound(sorted_capacities.begin(), sorted_capacities.end(), capacity)
+                          - sorted_capacities.begin();
+            double sum = 0;
+            for (size_t i = 0; i < last; i++) sum += hits[i];
+            result.push_back(std::min(std::max(sum, 0.0), requests));
+        }
+        return result;
+    }
+};
+
+inline CacheStats estimatedStats(double reads, double writes, double read_hits, double write_hits, double cold) {
+    CacheStats stats;
+    stats.total_reads = std::llround(reads);
+    stats.total_writes = std::llround(writes);
+    stats.total_requests = stats.total_reads + stats.total_writes;
+    stats.total_read_hits = std::llround(read_hits);
+    stats.total_write_hits = std::llround(write_hits);
+    stats.total_hits = stats.total_read_hits + stats.total_write_hits;
+    stats.total_read_misses = stats.total_reads - stats.total_read_hits;
+    stats.total_write_misses = stats.total_writes - stats.total_write_hits;
+    stats.total_misses = stats.total_read_misses + stats.total_write_misses;
+    stats.cold_misses = std::llround(cold);
+    return stats;
+}
+
+// Sampled LRU miss-ratio curve (SHARDS, fixed-size variant when sample_limit > 0)
+class ShardsLruAnalyzer {
+private:
+    std::vector<size_t> capacities;
+    uint64_t threshold;
+    size_t sample_limit;
+
+    StackDistanceTracker tracker;
+    std::priority_queue<std::pair<uint64_t, long long> > sampled;   // Max-heap of (hash, offset)
+    WeightedCurve read_curve;
+    WeightedCurve write_curve;
+    long long reads = 0;
+    long long writes = 0;
+    double cold = 0;
+
+    // Drop the offsets with the largest hash until the sample fits
+    void shrinkSample() {
+        while (sampled.size() > sample_limit) {
+            uint64_t largest = sampled.top().first;
+            while (!sampled.empty() && sampled.top().first == largest) {
+                tracker.remove(sampled.top().second);
+                sampled.pop();
+            }
+            threshold = largest;
+        }
+    }
+
+public:
+    // sample_limit = 0 keeps the rate fixed
+    ShardsLruAnalyzer(const std::vector<size_t>& caps, double rate, size_t limit)
+        : capacities(caps),
+          threshold(static_cast<uint64_t>(std::max(0.0, std::min(rate, 1.0)) * SHARDS_MODULUS)),
+          sample_limit(limit), read_curve(caps), write_curve(caps) {}
+
+    void access(long long offset, OpType type) {
+        WeightedCurve& curve = type == OpType::Read ? read_curve : write_curve;
+        if (type == OpType::Read) reads++;
+        else writes++;
+
+        uint64_t hash = shardsHash(offset);
+        if (hash >= threshold) return;
+
+        double rate = getRate();
+        size_t distance = tracker.access(offset);
+        curve.addRequest(1.0 / rate);
+        if (distance == 0) {
+            cold += 1.0 / rate;
+            if (sample_limit > 0) {
+                sampled.push({hash, offset});
+                shrinkSample();
+            }
+        } else {
+            curve.addHit(distance / rate, 1.0 / rate);
+        }
+    }
+
+    double getRate() const { return static_cast<double>(threshold) / SHARDS_MODULUS; }
+    size_t getSampledOffsets() const { return tracker.size(); }
+
+    // Estimated statistics of each capacity, in the order given at construction.
+    // Hit ratios are taken over the weighted sample and applied to the actual
+    // request counts, which keeps a heavily hit sampled offset from pushing
+    // the estimate past the trace totals.
+    std::vector<CacheStats> statsForCapacities() const {
+        std::vector<double> read_hits = read_curve.hitsForCapacities(capacities, read_curve.getTotal());
+        std::vector<double> write_hits = write_curve.hitsForCapacities(capacities, write_curve.getTotal());
+        double read_scale = read_curve.getTotal() > 0 ? reads / read_curve.getTotal() : 0.0;
+        double write_scale = write_curve.getTotal() > 0 ? writes / write_curve.getTotal() : 0.0;
+
+        double sampled_total = read_curve.getTotal() + write_curve.getTotal();
+        double cold_estimate = sampled_total > 0 ? cold * (reads + writes) / sampled_total : 0.0;
+
+        std::vector<CacheStats> result;
+        for (size_t i = 0; i < capacities.size(); i++) {
+            result.push_back(estimatedStats(static_cast<double>(reads), static_cast<double>(writes),
+                                            read_hits[i] * read_scale, write_hits[i] * write_scale, cold_estimate));
+        }
+        return result;
+    }
+};
+
+// Sampled ARC curve by miniature simulation at a fixed rate
+class ShardsArcAnalyzer {
+private:
+    std::vector<ARC_Cache> caches;
+    std::vector<CacheStats> sampled_stats;
+    uint64_t threshold;
+    long long reads = 0;
+    long long writes = 0;
+
+public:
+    ShardsArcAnalyzer(const std::vector<size_t>& capacities, double rate)
+        : sampled_stats(capacities.size()),
+          threshold(static_cast<uint64_t>(std::max(0.0, std::min(rate, 1.0)) * SHARDS_MODULUS)) {
+        for (size_t capacity : capacities) {
+            caches.emplace_back(static_cast<size_t>(std::max<double>(1.0, std::round(capacity * getRate()))));
+        }
+    }
+
+    void access(long long offset, OpType type) {
+        if (type == OpType::Read) reads++;
+        else writes++;
+        if (shardsHash(offset) >= threshold) return;
+        for (size_t i = 0; i < caches.size(); i++) {
+            sampled_stats[i].record(caches[i].access(offset, type), type);
+        }
+    }
+
+    double getRate() const { return static_cast<double>(threshold) / SHARDS_MODULUS; }
+
+    // Sampled hit ratios applied to the actual request counts
+    std::vector<CacheStats> statsForCapacities() const {
+        std::vector<CacheStats> result;
+        for (const CacheStats& s : sampled_stats) {
+            double read_ratio = s.total_reads > 0 ? static_cast<double>(s.total_read_hits) / s.total_reads : 0.0;
+            double write_ratio = s.total_writes > 0 ? static_cast<double>(s.total_write_hits) / s.total_writes : 0.0;
+            result.push_back(estimatedStats(static_cast<double>(reads), static_cast<double>(writes),
+                                            read_ratio * reads, write_ratio * writes, 0.0));
+        }
+        return result;
+    }
+};
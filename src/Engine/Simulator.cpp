@@ -0,0 +1,771 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Arc/ARC_Cache.h"
+#include "../Arc/LARC_Cache.h"
+#include "../LRU/LRU_Cache.h"
+#include "../N-hit/NHitCache.h"
+#include "../Oracle/BeladyCache.h"
+#include "../Common/BlockSimulation.h"
+#include "../Common/Checkpoint.h"
+#include "../Common/DenseKeys.h"
+#include "../Common/Metrics.h"
+#include "../Common/Simulation.h"
+#include "../Common/SizeList.h"
+#include "MultiSimulation.h"
+#include "ShardedSimulation.h"
+#include "Shards.h"
+
+// Single entry point for every policy. Each policy is plugged into the
+// templated driver in Simulation.h, so the trace loop is compiled once per
+// policy with access() inlined.
+
+template <class Policy>
+void runPolicy(Policy& policy, const std::string& filename, const TimeWindow& window,
+               IntervalMetrics* metrics = nullptr) {
+    CacheStats stats;
+    if (metrics == nullptr) {
+        if (!simulateTrace(filename, window, policy, stats)) return;
+    } else {
+        ColdMissTracker cold_tracker;
+        bool ok = forEachRequest(filename, window, [&](const TraceRecord& record) {
+            simulateRequestWithMetrics(policy, record, stats, cold_tracker, *metrics);
+        });
+        if (!ok) return;
+        metrics->finish(policy);
+    }
+    std::cout << "Policy: " << Policy::name() << std::endl;
+    printStats(stats);
+}
+
+// Run the loaded window through an offline policy
+template <class Policy>
+void runRecords(Policy& policy, const std::vector<TraceRecord>& sequence, IntervalMetrics* metrics) {
+    CacheStats stats;
+    if (metrics == nullptr) {
+        simulateRecords(sequence, policy, stats);
+    } else {
+        ColdMissTracker cold_tracker;
+        for (const TraceRecord& record : sequence) {
+            simulateRequestWithMetrics(policy, record, stats, cold_tracker, *metrics);
+        }
+        metrics->finish(policy);
+    }
+    std::cout << "Policy: " << Policy::name() << std::endl;
+    printStats(stats);
+}
+
+template <class Policy>
+void runPolicyBlocks(Policy& policy, const std::string& filename, const TimeWindow& window, uint32_t block_size) {
+    BlockStats stats;
+    if (!simulateTraceBlocks(filename, window, block_size, policy, stats)) return;
+    std::cout << "Policy: " << Policy::name() << ", block size: " << block_size << " bytes" << std::endl;
+    printBlockStats(stats);
+}
+
+std::string toUpper(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return text;
+}
+
+// Split a comma-separated list
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Simulate one policy; with_metrics also writes per-interval records (see Metrics.h)
+int runSinglePolicy(bool with_metrics) {
+    std::string policy, trace_file;
+    int cache_size;
+    long long start_time, end_time;
+
+    std::cout << "Enter policy (ARC, LARC, LRU, NHIT, NHITCMS, BELADY): ";
+    std::cin >> policy;
+    policy = toUpper(policy);
+
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter cache size: ";
+    std::cin >> cache_size;
+
+    int insertion_threshold = 0, piece_count = 0;
+    size_t sketch_budget_kb = 0;
+    if (policy == "NHIT" || policy == "NHITCMS") {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> insertion_threshold;
+    }
+    if (policy == "NHITCMS") {
+        std::cout << "Enter sketch memory budget (KB): ";
+        std::cin >> sketch_budget_kb;
+    } else if (policy == "BELADY") {
+        std::cout << "Enter piece number (Belady): ";
+        std::cin >> piece_count;
+    }
+
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+
+    MetricsInterval interval;
+    MetricsSink sink;
+    if (with_metrics) {
+        std::string interval_text, metrics_file;
+        std::cout << "Enter metrics interval (<n>s of trace time or <n>r requests): ";
+        std::cin >> interval_text;
+        std::cout << "Enter metrics output path (.csv, or .bin for binary): ";
+        std::cin >> metrics_file;
+        if (!parseMetricsInterval(interval_text, interval)) {
+            std::cerr << "Error: Invalid metrics interval " << interval_text << std::endl;
+            return 1;
+        }
+        if (!sink.open(metrics_file)) {
+            std::cerr << "Error: Could not create file " << metrics_file << std::endl;
+            return 1;
+        }
+    }
+    IntervalMetrics metrics(sink, interval);
+    IntervalMetrics* metrics_ptr = with_metrics ? &metrics : nullptr;
+
+    TimeWindow window = windowFromSeconds(start_time, end_time);
+
+    if (policy == "ARC") {
+        ARC_Cache cache(cache_size);
+        runPolicy(cache, trace_file, window, metrics_ptr);
+    } else if (policy == "LARC") {
+        LARC_Cache cache(cache_size);
+        runPolicy(cache, trace_file, window, metrics_ptr);
+    } else if (policy == "LRU") {
+        LRU_Cache cache(cache_size);
+        runPolicy(cache, trace_file, window, metrics_ptr);
+    } else if (policy == "NHIT") {
+        NHitCache cache(cache_size, insertion_threshold);
+        runPolicy(cache, trace_file, window, metrics_ptr);
+    } else if (policy == "NHITCMS") {
+        SketchNHitCache cache(cache_size, insertion_threshold, sketch_budget_kb * 1024);
+        runPolicy(cache, trace_file, window, metrics_ptr);
+    } else if (policy == "BELADY") {
+        // Belady needs the whole window up front
+        std::vector<TraceRecord> sequence;
+        if (!loadTraceWindow(trace_file, window, sequence) || !checkBeladySequence(sequence.size())) return 1;
+        if (piece_count <= 1) {
+            ExactBeladyCache cache(cache_size, sequence);
+            runRecords(cache, sequence, metrics_ptr);
+        } else {
+            BeladyCache cache(cache_size, piece_count, sequence);
+            runRecords(cache, sequence, metrics_ptr);
+        }
+    } else {
+        std::cerr << "Error: Unknown policy " << policy << std::endl;
+        return 1;
+    }
+    if (!sink.close()) {
+        std::cerr << "Error: Failed writing metrics" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+template <class Policy>
+void runDense(Policy& policy, const TraceColumns& columns) {
+    CacheStats stats;
+    simulateDense(columns, policy, stats);
+    std::cout << "Policy: " << Policy::name() << std::endl;
+    printStats(stats);
+}
+
+// Simulate one policy over a loaded window whose offsets are remapped to
+// dense ids (see DenseKeys.h), so the policy indexes arrays instead of hashing
+int runDensePolicy() {
+    std::string policy, trace_file;
+    int cache_size;
+    long long start_time, end_time;
+
+    std::cout << "Enter policy (ARC, LARC, LRU, NHIT): ";
+    std::cin >> policy;
+    policy = toUpper(policy);
+
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter cache size: ";
+    std::cin >> cache_size;
+
+    int insertion_threshold = 0;
+    if (policy == "NHIT") {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> insertion_threshold;
+    }
+
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+
+    if (policy != "ARC" && policy != "LARC" && policy != "LRU" && policy != "NHIT") {
+        std::cerr << "Error: Unknown policy " << policy << std::endl;
+        return 1;
+    }
+
+    TraceColumns columns;
+    if (!loadTraceWindow(trace_file, windowFromSeconds(start_time, end_time), columns)) return 1;
+    size_t distinct = 0;
+    if (!assignDenseKeys(columns, distinct)) return 1;
+    std::cout << "Distinct Offsets: " << distinct << std::endl;
+
+    if (policy == "ARC") {
+        DenseARC_Cache cache(cache_size, distinct);
+        runDense(cache, columns);
+    } else if (policy == "LARC") {
+        DenseLARC_Cache cache(cache_size, distinct);
+        runDense(cache, columns);
+    } else if (policy == "LRU") {
+        DenseLRU_Cache cache(cache_size, distinct);
+        runDense(cache, columns);
+    } else {
+        DenseNHitCache cache(cache_size, insertion_threshold, distinct);
+        runDense(cache, columns);
+    }
+    return 0;
+}
+
+// Simulate the window, saving a checkpoint of the run every `interval` ns of
+// trace time (see Checkpoint.h)
+template <class Policy>
+bool runWithCheckpoints(Policy& policy, const std::string& filename, const TimeWindow& window, long long interval,
+                        const std::string& prefix) {
+    CheckpointInfo info;
+    info.policy = Policy::name();
+    info.run_start = window.start_time;
+    if (!firstTraceTimestamp(filename, info.first_timestamp)) return false;
+    if (!startCheckpointList(prefix)) {
+        std::cerr << "Error: Could not create file " << checkpointListName(prefix) << std::endl;
+        return false;
+    }
+
+    // A checkpoint is taken when the first request at or after its time
+    // arrives; an idle stretch of the trace gets only its last checkpoint
+    ColdMissTracker cold_tracker;
+    long long next_checkpoint = (std::max(window.start_time, 0LL) / interval + 1) * interval;
+    size_t written = 0;
+    bool write_failed = false;
+    bool ok = forEachRequestAt(filename, window, nullptr, [&](const TraceRecord& record, const TracePosition& at) {
+        long long time = record.timestamp - info.first_timestamp;
+        if (time >= next_checkpoint && !write_failed) {
+            info.time = time / interval * interval;
+            info.resume = at;
+            std::string snapshot = checkpointFileName(prefix, info.time);
+            if (saveCheckpoint(snapshot, policy, info, cold_tracker) &&
+                addToCheckpointList(prefix, info.time, snapshot)) {
+                written++;
+            } else {
+                std::cerr << "Error: Could not write checkpoint " << snapshot << std::endl;
+                write_failed = true;
+            }
+            next_checkpoint = info.time + interval;
+        }
+        simulateRequest(policy, record, info.stats, &cold_tracker);
+    });
+    if (!ok) return false;
+
+    std::cout << "Checkpoints Written: " << written << std::endl;
+    std::cout << "Policy: " << Policy::name() << std::endl;
+    printStats(info.stats);
+    return !write_failed;
+}
+
+// Simulate the window with the state of the latest checkpoint at or before
+// its start, replaying only the requests between the two. The replay starts
+// at the checkpoint's position in the trace and keeps the checkpointed run's
+// start time, so it sees the same requests as the run did. Without a
+// checkpoint the whole prefix of the trace is replayed.
+template <class Policy>
+bool runFromCheckpoint(Policy& policy, const std::string& filename, const TimeWindow& window,
+                       const std::string& prefix) {
+    long long first_timestamp;
+    if (!firstTraceTimestamp(filename, first_timestamp)) return false;
+
+    CheckpointInfo info;
+    ColdMissTracker cold_tracker;
+    std::string snapshot;
+    long long checkpoint_time = 0;
+    const TracePosition* resume = nullptr;
+    TimeWindow replay = {0, window.end_time};
+    if (findCheckpoint(prefix, window.start_time, snapshot, checkpoint_time)) {
+        std::string error;
+        if (!loadCheckpoint(snapshot, policy, info, cold_tracker, error)) {
+            std::cerr << "Error: Could not restore checkpoint: " << error << std::endl;
+            return false;
+        }
+        if (info.first_timestamp != first_timestamp) {
+            std::cerr << "Error: Checkpoint " << snapshot << " was taken on a different trace" << std::endl;
+            return false;
+        }
+        std::cout << "Restored Checkpoint: " << snapshot << " (run from " << info.run_start / NANOSECONDS_PER_SECOND
+                  << "s, " << info.stats.total_requests << " requests)" << std::endl;
+        resume = &info.resume;
+        replay.start_time = info.run_start;
+    } else {
+        std::cout << "No checkpoint at or before the start time; replaying from the start of the trace" << std::endl;
+    }
+
+    CacheStats stats;
+    long long replayed = 0;
+    bool ok = forEachRequestAt(filename, replay, resume, [&](const TraceRecord& record, const TracePosition&) {
+        if (record.timestamp - first_timestamp >= window.start_time) {
+            simulateRequest(policy, record, stats, &cold_tracker);
+            return;
+        }
+        if (!policy.access(record.offset, record.type)) cold_tracker.firstReference(record.offset);
+        replayed++;
+    });
+    if (!ok) return false;
+
+    std::cout << "Replayed Requests: " << replayed << std::endl;
+    std::cout << "Policy: " << Policy::name() << std::endl;
+    printStats(stats);
+    return true;
+}
+
+// Mode 8 (checkpoint) takes checkpoints during a run; mode 9 (warm start)
+// resumes from them
+int runCheckpointMode(bool warm_start) {
+    std::string policy, trace_file, prefix;
+    int cache_size;
+    long long start_time, end_time, interval = 0;
+
+    std::cout << "Enter policy (ARC, LARC, LRU, NHIT, NHITCMS): ";
+    std::cin >> policy;
+    policy = toUpper(policy);
+
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter cache size: ";
+    std::cin >> cache_size;
+
+    int insertion_threshold = 0;
+    size_t sketch_budget_kb = 0;
+    if (policy == "NHIT" || policy == "NHITCMS") {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> insertion_threshold;
+    }
+    if (policy == "NHITCMS") {
+        std::cout << "Enter sketch memory budget (KB): ";
+        std::cin >> sketch_budget_kb;
+    }
+
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+    if (!warm_start) {
+        std::cout << "Enter checkpoint interval (seconds of trace time): ";
+        std::cin >> interval;
+        if (interval <= 0) {
+            std::cerr << "Error: Checkpoint interval must be positive" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Enter checkpoint path prefix: ";
+    std::cin >> prefix;
+
+    TimeWindow window = windowFromSeconds(start_time, end_time);
+    auto run = [&](auto& cache) {
+        return warm_start ? runFromCheckpoint(cache, trace_file, window, prefix)
+                          : runWithCheckpoints(cache, trace_file, window, interval * NANOSECONDS_PER_SECOND, prefix);
+    };
+
+    bool ok;
+    if (policy == "ARC") {
+        ARC_Cache cache(cache_size);
+        ok = run(cache);
+    } else if (policy == "LARC") {
+        LARC_Cache cache(cache_size);
+        ok = run(cache);
+    } else if (policy == "LRU") {
+        LRU_Cache cache(cache_size);
+        ok = run(cache);
+    } else if (policy == "NHIT") {
+        NHitCache cache(cache_size, insertion_threshold);
+        ok = run(cache);
+    } else if (policy == "NHITCMS") {
+        SketchNHitCache cache(cache_size, insertion_threshold, sketch_budget_kb * 1024);
+        ok = run(cache);
+    } else {
+        std::cerr << "Error: Unknown policy " << policy << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
+
+// Simulate one policy over the fixed-size blocks each request covers
+int runBlockPolicy() {
+    std::string policy, trace_file;
+    int cache_size;
+    uint32_t block_size;
+    long long start_time, end_time;
+
+    std::cout << "Enter policy (ARC, LARC, LRU, NHIT, NHITCMS, BELADY): ";
+    std::cin >> policy;
+    policy = toUpper(policy);
+
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter cache size (blocks): ";
+    std::cin >> cache_size;
+    std::cout << "Enter block size (bytes): ";
+    std::cin >> block_size;
+    if (block_size == 0) {
+        std::cerr << "Error: Block size must be positive" << std::endl;
+        return 1;
+    }
+
+    int insertion_threshold = 0, piece_count = 0;
+    size_t sketch_budget_kb = 0;
+    if (policy == "NHIT" || policy == "NHITCMS") {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> insertion_threshold;
+    }
+    if (policy == "NHITCMS") {
+        std::cout << "Enter sketch memory budget (KB): ";
+        std::cin >> sketch_budget_kb;
+    } else if (policy == "BELADY") {
+        std::cout << "Enter piece number (Belady): ";
+        std::cin >> piece_count;
+    }
+
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+
+    TimeWindow window = windowFromSeconds(start_time, end_time);
+
+    if (policy == "ARC") {
+        ARC_Cache cache(cache_size);
+        runPolicyBlocks(cache, trace_file, window, block_size);
+    } else if (policy == "LARC") {
+        LARC_Cache cache(cache_size);
+        runPolicyBlocks(cache, trace_file, window, block_size);
+    } else if (policy == "LRU") {
+        LRU_Cache cache(cache_size);
+        runPolicyBlocks(cache, trace_file, window, block_size);
+    } else if (policy == "NHIT") {
+        NHitCache cache(cache_size, insertion_threshold);
+        runPolicyBlocks(cache, trace_file, window, block_size);
+    } else if (policy == "NHITCMS") {
+        SketchNHitCache cache(cache_size, insertion_threshold, sketch_budget_kb * 1024);
+        runPolicyBlocks(cache, trace_file, window, block_size);
+    } else if (policy == "BELADY") {
+        // Belady is built over the block sequence and driven request by request
+        std::vector<TraceRecord> sequence;
+        if (!loadTraceWindow(trace_file, window, sequence)) return 1;
+        std::vector<TraceRecord> blocks = expandToBlocks(sequence, block_size);
+        if (!checkBeladySequence(blocks.size())) return 1;
+        BlockStats stats;
+        if (piece_count <= 1) {
+            ExactBeladyCache cache(cache_size, blocks);
+            simulateRecordBlocks(sequence, block_size, cache, stats);
+        } else {
+            BeladyCache cache(cache_size, piece_count, blocks);
+            simulateRecordBlocks(sequence, block_size, cache, stats);
+        }
+        std::cout << "Policy: " << BeladyCache::name() << ", block size: " << block_size << " bytes" << std::endl;
+        printBlockStats(stats);
+    } else {
+        std::cerr << "Error: Unknown policy " << policy << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Compare several policies and cache sizes over a single read of the trace.
+// With with_costs, also charge each request's latency (see CostModel.h).
+int runComparison(bool with_costs) {
+    std::string policy_list, size_list, trace_file;
+    PolicyParameters params;
+    long long start_time, end_time;
+    unsigned thread_count;
+
+    std::cout << "Enter policies (comma-separated, e.g. ARC,LARC,LRU,NHIT,NHITCMS,BELADY): ";
+    std::cin >> policy_list;
+    std::cout << "Enter cache sizes (comma-separated): ";
+    std::cin >> size_list;
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+
+    std::vector<std::string> policies = splitList(toUpper(policy_list));
+    bool has_nhit = std::find(policies.begin(), policies.end(), "NHIT") != policies.end();
+    bool has_sketch = std::find(policies.begin(), policies.end(), "NHITCMS") != policies.end();
+    bool has_belady = std::find(policies.begin(), policies.end(), "BELADY") != policies.end();
+    if (has_nhit || has_sketch) {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> params.insertion_threshold;
+    }
+    if (has_sketch) {
+        std::cout << "Enter sketch memory budget (KB): ";
+        std::cin >> params.sketch_budget_kb;
+    }
+    if (has_belady) {
+        std::cout << "Enter piece number (Belady): ";
+        std::cin >> params.piece_count;
+    }
+
+    CostModel cost_model;
+    if (with_costs) {
+        std::cout << "Enter read hit service time (trace response-time units): ";
+        std::cin >> cost_model.read_hit_time;
+        std::cout << "Enter write hit service time (trace response-time units): ";
+        std::cin >> cost_model.write_hit_time;
+    }
+
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+    std::cout << "Enter worker threads (0 = all cores): ";
+    std::cin >> thread_count;
+
+    std::vector<size_t> sizes;
+    if (!parseSizeList(size_list, sizes)) {
+        std::cerr << "Error: bad cache size" << std::endl;
+        return 1;
+    }
+
+    TimeWindow window = windowFromSeconds(start_time, end_time);
+
+    // Belady needs the whole window up front; the other policies stream
+    std::vector<TraceRecord> sequence;
+    if (has_belady && (!loadTraceWindow(trace_file, window, sequence) || !checkBeladySequence(sequence.size()))) {
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<SimulationJob> > jobs;
+    for (const std::string& policy : policies) {
+        for (size_t size : sizes) {
+            auto job = makeSimulationJob(policy, size, params, &sequence);
+            if (!job) {
+                std::cerr << "Error: Unknown policy " << policy << std::endl;
+                return 1;
+            }
+            if (with_costs) job->cost_model = &cost_model;
+            jobs.push_back(std::move(job));
+        }
+    }
+
+    if (runJobsInParallel(trace_file, window, has_belady ? &sequence : nullptr, jobs, thread_count) < 0) {
+        return 1;
+    }
+    if (with_costs) printCostTable(jobs);
+    else printComparisonTable(jobs);
+    return 0;
+}
+
+// Simulate a cache split into hash-partitioned shards, one worker thread each
+int runShardedPolicy() {
+    std::string policy, trace_file;
+    PolicyParameters params;
+    size_t shard_count, shard_size;
+    long long start_time, end_time;
+
+    std::cout << "Enter policy (ARC, LARC, LRU, NHIT, NHITCMS): ";
+    std::cin >> policy;
+    policy = toUpper(policy);
+
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter number of shards: ";
+    std::cin >> shard_count;
+    std::cout << "Enter cache size per shard: ";
+    std::cin >> shard_size;
+    if (policy == "NHIT" || policy == "NHITCMS") {
+        std::cout << "Enter insertion threshold (N-hit): ";
+        std::cin >> params.insertion_threshold;
+    }
+    if (policy == "NHITCMS") {
+        std::cout << "Enter sketch memory budget per shard (KB): ";
+        std::cin >> params.sketch_budget_kb;
+    }
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+
+    if (shard_count == 0) {
+        std::cerr << "Error: Number of shards must be positive" << std::endl;
+        return 1;
+    }
+    // Belady would need each shard's future requests up front
+    std::vector<std::unique_ptr<SimulationJob> > jobs;
+    for (size_t s = 0; s < shard_count && policy != "BELADY"; s++) {
+        auto job = makeSimulationJob(policy, shard_size, params, nullptr);
+        if (!job) break;
+        jobs.push_back(std::move(job));
+    }
+    if (jobs.size() != shard_count) {
+        std::cerr << "Error: Unknown policy " << policy << std::endl;
+        return 1;
+    }
+
+    ShardedSimulation simulation(std::move(jobs));
+    if (!simulation.run(trace_file, windowFromSeconds(start_time, end_time))) return 1;
+    std::cout << "Policy: " << simulation.getJob(0).policy_name << ", shards: " << shard_count
+              << ", cache size per shard: " << shard_size << std::endl;
+    printShardTable(simulation);
+    return 0;
+}
+
+// Estimate LRU and ARC miss-ratio curves from a hashed sample of the offsets,
+// optionally next to the exact curves to measure the sampling error
+int runSampledCurves() {
+    std::string policy_list, size_list, trace_file, compare;
+    double rate;
+    size_t sample_limit;
+    long long start_time, end_time;
+
+    std::cout << "Enter policies (comma-separated, LRU and/or ARC): ";
+    std::cin >> policy_list;
+    std::cout << "Enter cache sizes (comma-separated): ";
+    std::cin >> size_list;
+    std::cout << "Enter trace file path: ";
+    std::cin >> trace_file;
+    std::cout << "Enter sampling rate (0-1, e.g. 0.01): ";
+    std::cin >> rate;
+    std::cout << "Enter maximum sampled offsets (0 = fixed rate): ";
+    std::cin >> sample_limit;
+    std::cout << "Enter start time (relative, in seconds): ";
+    std::cin >> start_time;
+    std::cout << "Enter end time (relative, in seconds): ";
+    std::cin >> end_time;
+    std::cout << "Compare with exact simulation (y/n): ";
+    std::cin >> compare;
+
+    std::vector<std::string> policies = splitList(toUpper(policy_list));
+    bool has_lru = std::find(policies.begin(), policies.end(), "LRU") != policies.end();
+    bool has_arc = std::find(policies.begin(), policies.end(), "ARC") != policies.end();
+    bool exact = toUpper(compare) == "Y";
+    for (const std::string& policy : policies) {
+        if (policy != "LRU" && policy != "ARC") {
+            std::cerr << "Error: Sampling supports LRU and ARC, not " << policy << std::endl;
+            return 1;
+        }
+    }
+    if (rate <= 0 || rate > 1) {
+        std::cerr << "Error: Sampling rate must be in (0, 1]" << std::endl;
+        return 1;
+    }
+
+    std::vector<size_t> capacities;
+    if (!parseSizeList(size_list, capacities)) {
+        std::cerr << "Error: bad cache size" << std::endl;
+        return 1;
+    }
+
+    // ARC keeps up to two entries of history per cached entry, so with a
+    // sample limit its rate is chosen to keep the miniature caches within it
+    double arc_rate = rate;
+    if (sample_limit > 0) {
+        size_t total_capacity = 0;
+        for (size_t capacity : capacities) total_capacity += capacity;
+        arc_rate = std::min(rate, static_cast<double>(sample_limit) / (2.0 * std::max<size_t>(total_capacity, 1)));
+    }
+
+    ShardsLruAnalyzer sampled_lru(capacities, rate, sample_limit);
+    ShardsArcAnalyzer sampled_arc(capacities, arc_rate);
+    StackDistanceAnalyzer exact_lru;
+    std::vector<ARC_Cache> exact_arc;
+    std::vector<CacheStats> exact_arc_stats(capacities.size());
+    if (exact && has_arc) {
+        for (size_t capacity : capacities) exact_arc.emplace_back(capacity);
+    }
+
+    bool ok = forEachRequest(trace_file, windowFromSeconds(start_time, end_time), [&](const TraceRecord& record) {
+        if (has_lru) {
+            sampled_lru.access(record.offset, record.type);
+            if (exact) exact_lru.access(record.offset, record.type);
+        }
+        if (has_arc) {
+            sampled_arc.access(record.offset, record.type);
+            for (size_t i = 0; i < exact_arc.size(); i++) {
+                exact_arc_stats[i].record(exact_arc[i].access(record.offset, record.type), record.type);
+            }
+        }
+    });
+    if (!ok) return 1;
+
+    if (has_lru) {
+        std::cout << "LRU sampling rate: " << sampled_lru.getRate()
+                  << ", sampled offsets: " << sampled_lru.getSampledOffsets() << std::endl;
+    }
+    if (has_arc) std::cout << "ARC sampling rate: " << sampled_arc.getRate() << std::endl;
+
+    std::cout << std::left << std::setw(8) << "Policy" << std::right << std::setw(12) << "Capacity"
+              << std::setw(12) << "Sampled";
+    if (exact) std::cout << std::setw(12) << "Exact" << std::setw(12) << "AbsError";
+    std::cout << std::endl;
+
+    for (const std::string& policy : policies) {
+        std::vector<CacheStats> sampled = policy == "LRU" ? sampled_lru.statsForCapacities()
+                                                          : sampled_arc.statsForCapacities();
+        std::vector<CacheStats> reference;
+        if (exact) reference = policy == "LRU" ? exact_lru.statsForCapacities(capacities) : exact_arc_stats;
+
+        double error_sum = 0, error_max = 0;
+        std::cout << std::fixed << std::setprecision(2);
+        for (size_t i = 0; i < capacities.size(); i++) {
+            std::cout << std::left << std::setw(8) << policy << std::right << std::setw(12) << capacities[i]
+                      << std::setw(11) << sampled[i].hitRate() << "%";
+            if (exact) {
+                double error = std::fabs(sampled[i].hitRate() - reference[i].hitRate());
+                error_sum += error;
+                error_max = std::max(error_max, error);
+                std::cout << std::setw(11) << reference[i].hitRate() << "%" << std::setw(11) << error << "%";
+            }
+            std::cout << std::endl;
+        }
+        if (exact && !capacities.empty()) {
+            std::cout << policy << " mean absolute error: " << error_sum / capacities.size()
+                      << "%, max: " << error_max << "%" << std::endl;
+        }
+        std::cout << std::defaultfloat;
+    }
+    return 0;
+}
+
+int main() {
+    int mode;
+    std::cout << "Select mode (1 = single policy, 2 = compare policies and cache sizes, "
+                 "3 = sampled miss-ratio curves, 4 = block-granular single policy, "
+                 "5 = compare policies by latency, 6 = single policy with interval metrics, "
+                 "7 = single policy on dense keys, 8 = single policy with checkpoints, "
+                 "9 = single policy from a checkpoint, 10 = sharded single policy): ";
+    std::cin >> mode;
+
+    switch (mode) {
+        case 1: return runSinglePolicy(false);
+        case 2: return runComparison(false);
+        case 3: return runSampledCurves();
+        case 4: return runBlockPolicy();
+        case 5: return runComparison(true);
+        case 6: return runSinglePolicy(true);
+        case 7: return runDensePolicy();
+        case 8: return runCheckpointMode(false);
+        case 9: return runCheckpointMode(true);
+        case 10: return runShardedPolicy();
+        default:
+            std::cerr << "Error: Unknown mode " << mode << std::endl;
+            return 1;
+    }
+}
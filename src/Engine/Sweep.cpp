@@ -0,0 +1,45 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Sweep.h"
+
+// Batch front-end: runs every job of a sweep spec (see Sweep.h) and writes
+// the results as CSV or JSON. The spec path is taken from the command line,
+// or prompted for when none is given.
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string spec_path;
+    if (argc > 1) {
+        spec_path = argv[1];
+    } else {
+        std::cout << "Enter sweep spec path: ";
+        std::cin >> spec_path;
+    }
+
+    SweepSpec spec;
+    if (!parseSweepSpec(spec_path, spec)) return 1;
+
+    std::vector<SweepResult> results;
+    if (!runSweep(spec, results)) return 1;
+
+    bool json = endsWith(spec.output, ".json");
+    if (spec.output == "-") {
+        writeSweepCsv(std::cout, results);
+        return 0;
+    }
+    std::ofstream out(spec.output);
+    if (!out) {
+        std::cerr << "Error: Could not write " << spec.output << std::endl;
+        return 1;
+    }
+    if (json) writeSweepJson(out, results);
+    else writeSweepCsv(out, results);
+    std::cout << "Wrote " << results.size() << " results to " << spec.output << std::endl;
+    return 0;
+}
@@ -0,0 +1,390 @@
+#pragma once
+
+// Batch parameter sweeps over policies, cache sizes, policy parameters and
+// time windows.
+//
+// A sweep spec is a text file of `key = value` lines; '#' starts a comment
+// and lists are comma-separated:
+//     traces     = a.csv, b.bin      each trace is read once; gen:... specs
+//                                    (Workload.h) are generated instead
+//     policies   = ARC,LRU,NHIT,NHITCMS,BELADY
+//     sizes      = 1000,10000
+//     thresholds = 2,3               N-hit insertion thresholds (default 2)
+//     pieces     = 1,4               Belady piece numbers (default 1)
+//     sketch_kb  = 1024              NHITCMS sketch budgets (default 1024)
+//     windows    = 0-3600, all       relative seconds, or the whole trace
+//     threads    = 0                 0 = all cores
+//     output     = results.csv       .json selects JSON, - writes CSV to stdout
+// Every combination of the parameters a policy uses becomes one job. Each
+// trace is loaded into one immutable buffer that all jobs on it share, and
+// the jobs run longest first on a work-stealing pool.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MultiSimulation.h"
+#include "../Common/SizeList.h"
+#include "WorkStealingPool.h"
+
+struct SweepWindow {
+    bool whole_trace = true;
+    long long start_seconds = 0;
+    long long end_seconds = 0;
+};
+
+struct SweepSpec {
+    std::vector<std::string> traces;
+    std::vector<std::string> policies;
+    std::vector<size_t> sizes;
+    std::vector<int> thresholds{2};
+    std::vector<int> pieces{1};
+    std::vector<size_t> sketch_kb{1024};
+    std::vector<SweepWindow> windows{SweepWindow()};
+    unsigned threads = 0;
+    std::string output = "-";
+};
+
+struct SweepResult {
+    std::string trace;
+    SweepWindow window;
+    std::string policy;
+    size_t capacity = 0;
+    PolicyParameters params;
+    CacheStats stats;
+    double seconds = 0;
+};
+
+namespace sweep_detail {
+
+inline std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+inline std::vector<std::string> splitTrimmed(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+inline bool isKnownPolicy(const std::string& policy) {
+    return policy == "ARC" || policy == "LARC" || policy == "LRU" || policy == "NHIT" ||
+           policy == "NHITCMS" || policy == "BELADY";
+}
+
+inline bool parseWindow(const std::string& text, SweepWindow& window) {
+    if (text == "all") {
+        window = SweepWindow();
+        return true;
+    }
+    size_t dash = text.find('-', 1);
+    if (dash == std::string::npos) return false;
+    window.whole_trace = false;
+    window.start_seconds = std::stoll(text.substr(0, dash));
+    window.end_seconds = std::stoll(text.substr(dash + 1));
+    return true;
+}
+
+// Read the whole trace into memory, decoding on all cores
+inline bool loadWholeTrace(const std::string& filename, std::vector<TraceRecord>& records) {
+    if (isWorkloadName(filename)) {
+        return loadTraceWindow(filename, {0, std::numeric_limits<long long>::max()}, records);
+    }
+    TraceReader reader(filename);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    TraceIndex index;
+    index.loadOrBuild(filename, reader);
+    size_t skipped_lines = loadWindowParallel(filename, reader, index, std::numeric_limits<long long>::min(),
+                                              std::numeric_limits<long long>::max(), records);
+    if (skipped_lines > 0) {
+        std::cerr << "Warning: Skipped " << skipped_lines << " malformed rows in " << filename << std::endl;
+    }
+    return true;
+}
+
+inline std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+inline bool usesThreshold(const std::string& policy) { return policy == "NHIT" || policy == "NHITCMS"; }
+
+} // namespace sweep_detail
+
+// Parse a sweep spec file; prints the problem and returns false on error
+inline bool parseSweepSpec(const std::string& path, SweepSpec& spec) {
+    using namespace sweep_detail;
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open sweep spec " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Error: " << path << ":" << line_number << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::vector<std::string> values = splitTrimmed(line.substr(equals + 1));
+
+        try {
+            if (key == "traces" || key == "trace") {
+                spec.traces = values;
+            } else if (key == "policies") {
+                spec.policies.clear();
+                for (const std::string& value : values) {
+                    std::string policy = value;
+                    for (char& c : policy) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                    if (!isKnownPolicy(policy)) {
+                        std::cerr << "Error: " << path << ":" << line_number << ": unknown policy " << value << std::endl;
+                        return false;
+                    }
+                    spec.policies.push_back(policy);
+                }
+            } else if (key == "sizes") {
+                spec.sizes.clear();
+                for (const std::string& value : values) {
+                    size_t size;
+                    if (!parseCacheSize(value, size)) {
+                        std::cerr << "Error: " << path << ":" << line_number << ": invalid number " << value << std::endl;
+                        return false;
+                    }
+                    spec.sizes.push_back(size);
+                }
+            } else if (key == "thresholds") {
+                spec.thresholds.clear();
+                for (const std::string& value : values) spec.thresholds.push_back(std::stoi(value));
+            } else if (key == "pieces") {
+                spec.pieces.clear();
+                for (const std::string& value : values) spec.pieces.push_back(std::stoi(value));
+            } else if (key == "sketch_kb") {
+                spec.sketch_kb.clear();
+                for (const std::string& value : values) {
+                    size_t budget;
+                    if (!parseCacheSize(value, budget)) {
+                        std::cerr << "Error: " << path << ":" << line_number << ": invalid number " << value << std::endl;
+                        return false;
+                    }
+                    spec.sketch_kb.push_back(budget);
+                }
+            } else if (key == "windows") {
+                spec.windows.clear();
+                for (const std::string& value : values) {
+                    SweepWindow window;
+                    if (!parseWindow(value, window)) {
+                        std::cerr << "Error: " << path << ":" << line_number << ": invalid window " << value << std::endl;
+                        return false;
+                    }
+                    spec.windows.push_back(window);
+                }
+            } else if (key == "threads") {
+                spec.threads = static_cast<unsigned>(values.empty() ? 0 : std::stoul(values[0]));
+            } else if (key == "output") {
+                spec.output = values.empty() ? "-" : values[0];
+            } else {
+                std::cerr << "Error: " << path << ":" << line_number << ": unknown key " << key << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: " << path << ":" << line_number << ": invalid number" << std::endl;
+            return false;
+        }
+    }
+
+    if (spec.traces.empty() || spec.policies.empty() || spec.sizes.empty() || spec.windows.empty() ||
+        spec.thresholds.empty() || spec.pieces.empty() || spec.sketch_kb.empty()) {
+        std::cerr << "Error: " << path << ": traces, policies and sizes are required and no list may be empty"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Run every job of the spec; results are in spec order (trace, window,
+// policy, parameters, size). Returns false if a trace could not be read, or
+// a window is too long for Belady.
+inline bool runSweep(const SweepSpec& spec, std::vector<SweepResult>& results) {
+    using namespace sweep_detail;
+    bool has_belady = std::find(spec.policies.begin(), spec.policies.end(), "BELADY") != spec.policies.end();
+
+    // One shared, read-only buffer per trace and window
+    struct WindowData {
+        std::string trace;
+        SweepWindow window;
+        std::shared_ptr<const std::vector<TraceRecord> > records;
+        long long cold_misses = 0;
+    };
+    std::vector<WindowData> inputs;
+    for (const std::string& trace : spec.traces) {
+        auto all = std::make_shared<std::vector<TraceRecord> >();
+        if (!loadWholeTrace(trace, *all)) return false;
+        std::shared_ptr<const std::vector<TraceRecord> > whole = all;
+        long long first_timestamp = all->empty() ? 0 : all->front().timestamp;
+
+        for (const SweepWindow& window : spec.windows) {
+            WindowData input{trace, window, whole, 0};
+            if (!window.whole_trace) {
+                TimeWindow range = windowFromSeconds(window.start_seconds, window.end_seconds);
+                auto part = std::make_shared<std::vector<TraceRecord> >();
+                for (const TraceRecord& record : *whole) {
+                    long long relative = record.timestamp - first_timestamp;
+                    if (relative >= range.start_time && relative <= range.end_time) part->push_back(record);
+                }
+                input.records = part;
+            }
+            if (has_belady && !checkBeladySequence(input.records->size())) return false;
+            ColdMissTracker cold_tracker;
+            for (const TraceRecord& record : *input.records) {
+                if (cold_tracker.firstReference(record.offset)) input.cold_misses++;
+            }
+            inputs.push_back(input);
+        }
+    }
+
+    // Expand the parameter combinations each policy uses
+    results.clear();
+    std::vector<size_t> input_of;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (const std::string& policy : spec.policies) {
+            std::vector<PolicyParameters> variants;
+            if (usesThreshold(policy)) {
+                for (int threshold : spec.thresholds) {
+                    if (policy == "NHIT") {
+                        PolicyParameters params;
+                        params.insertion_threshold = threshold;
+                        variants.push_back(params);
+                        continue;
+                    }
+                    for (size_t budget : spec.sketch_kb) {
+                        PolicyParameters params;
+                        params.insertion_threshold = threshold;
+                        params.sketch_budget_kb = budget;
+                        variants.push_back(params);
+                    }
+                }
+            } else if (policy == "BELADY") {
+                for (int piece_count : spec.pieces) {
+                    PolicyParameters params;
+                    params.piece_count = piece_count;
+                    variants.push_back(params);
+                }
+            } else {
+                variants.push_back(PolicyParameters());
+            }
+
+            for (const PolicyParameters& params : variants) {
+                for (size_t size : spec.sizes) {
+                    SweepResult result;
+                    result.trace = inputs[i].trace;
+                    result.window = inputs[i].window;
+                    result.policy = policy;
+                    result.capacity = size;
+                    result.params = params;
+                    results.push_back(result);
+                    input_of.push_back(i);
+                }
+            }
+        }
+    }
+
+    std::vector<PoolTask> tasks;
+    for (size_t j = 0; j < results.size(); j++) {
+        const WindowData& input = inputs[input_of[j]];
+        PoolTask task;
+        task.estimated_cost = estimatedPolicyCost(results[j].policy, results[j].params) *
+                              static_cast<double>(input.records->size());
+        task.run = [&results, &input, j] {
+            SweepResult& result = results[j];
+            auto started = std::chrono::steady_clock::now();
+            std::unique_ptr<SimulationJob> job =
+                makeSimulationJob(result.policy, result.capacity, result.params, input.records.get());
+            const std::vector<TraceRecord>& records = *input.records;
+            job->runBatch(records.data(), records.data() + records.size());
+            result.stats = job->getStats();
+            result.stats.cold_misses = input.cold_misses;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        };
+        tasks.push_back(std::move(task));
+    }
+
+    WorkStealingPool pool;
+    pool.run(std::move(tasks), spec.threads);
+    return true;
+}
+
+inline void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "trace,start_s,end_s,policy,capacity,threshold,pieces,sketch_kb,requests,hits,misses,cold_misses,"
+           "reads,writes,read_hits,write_hits,hit_rate,seconds\n";
+    for (const SweepResult& r : results) {
+        const CacheStats& s = r.stats;
+        out << r.trace << ",";
+        if (!r.window.whole_trace) out << r.window.start_seconds << "," << r.window.end_seconds;
+        else out << ",";
+        out << "," << r.policy << "," << r.capacity << ",";
+        if (sweep_detail::usesThreshold(r.policy)) out << r.params.insertion_threshold;
+        out << ",";
+        if (r.policy == "BELADY") out << r.params.piece_count;
+        out << ",";
+        if (r.policy == "NHITCMS") out << r.params.sketch_budget_kb;
+        out << "," << s.total_requests << "," << s.total_hits << "," << s.total_misses << "," << s.cold_misses
+            << "," << s.total_reads << "," << s.total_writes << "," << s.total_read_hits << "," << s.total_write_hits
+            << "," << std::fixed << std::setprecision(4) << s.hitRate() << "," << r.seconds << std::defaultfloat
+            << "\n";
+    }
+}
+
+inline void writeSweepJson(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const SweepResult& r = results[i];
+        const CacheStats& s = r.stats;
+        out << "  {\"trace\": " << sweep_detail::jsonString(r.trace);
+        if (!r.window.whole_trace) {
+            out << ", \"start_s\": " << r.window.start_seconds << ", \"end_s\": " << r.window.end_seconds;
+        }
+        out << ", \"policy\": \"" << r.policy << "\", \"capacity\": " << r.capacity;
+        if (sweep_detail::usesThreshold(r.policy)) out << ", \"threshold\": " << r.params.insertion_threshold;
+        if (r.policy == "BELADY") out << ", \"pieces\": " << r.params.piece_count;
+        if (r.policy == "NHITCMS") out << ", \"sketch_kb\": " << r.params.sketch_budget_kb;
+        out << ", \"requests\": " << s.total_requests << ", \"hits\": " << s.total_hits
+            << ", \"misses\": " << s.total_misses << ", \"cold_misses\": " << s.cold_misses
+            << ", \"reads\": " << s.total_reads << ", \"writes\": " << s.total_writes
+            << ", \"read_hits\": " << s.total_read_hits << ", \"write_hits\": " << s.total_write_hits
+            << ", \"hit_rate\": " << std::fixed << std::setprecision(4) << s.hitRate()
+            << ", \"seconds\": " << r.seconds << std::defaultfloat << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
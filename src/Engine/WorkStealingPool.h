@@ -0,0 +1,68 @@
+#pragma once
+
+// Runs independent tasks of uneven length on a fixed set of threads.
+//
+// Tasks are sorted by estimated cost, longest first, and dealt round-robin
+// to per-worker deques. A worker takes tasks from the front of its own deque
+// and, once it is empty, steals the front (longest remaining) task of the
+// first worker that still has one. Long tasks therefore start early and the
+// short ones fill in at the end, so no worker sits idle behind a late long
+// task.
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PoolTask {
+    double estimated_cost = 1.0;
+    std::function<void()> run;
+};
+
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<PoolTask> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue> > queues;
+
+    bool take(size_t worker, PoolTask& task) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            WorkerQueue& queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+public:
+    // Run every task on up to thread_count threads (0 = all cores) and wait
+    void run(std::vector<PoolTask> tasks, unsigned thread_count) {
+        if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+        thread_count = std::min<unsigned>(thread_count, static_cast<unsigned>(std::max<size_t>(tasks.size(), 1)));
+
+        std::stable_sort(tasks.begin(), tasks.end(), [](const PoolTask& a, const PoolTask& b) {
+            return a.estimated_cost > b.estimated_cost;
+        });
+        queues.clear();
+        for (unsigned w = 0; w < thread_count; w++) queues.emplace_back(new WorkerQueue());
+        for (size_t i = 0; i < tasks.size(); i++) queues[i % thread_count]->tasks.push_back(std::move(tasks[i]));
+
+        std::vector<std::thread> workers;
+        for (unsigned w = 0; w < thread_count; w++) {
+            workers.emplace_back([this, w] {
+                PoolTask task;
+                while (take(w, task)) task.run();
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../Common/NodePool.h"
+#include "../Common/TraceRecord.h"
+
+// LRU over a fixed pool of entries. Recency is a doubly linked list threaded
+// through the pool with 32-bit indices, and offsets are located through an
+// open-addressing index. All memory is allocated in the constructor, so
+// access() never allocates. Pool is NodePool for raw offsets or
+// DenseNodePool for dense key ids (see DenseKeys.h).
+template <class Pool>
+class BasicLRUCache {
+private:
+    size_t capacity;
+    Pool pool;
+    NodeList recency;
+
+public:
+    // key_count is the number of dense ids for DenseNodePool
+    explicit BasicLRUCache(size_t cap, size_t key_count = 0)
+        : capacity(cap < NO_NODE ? cap : NO_NODE - 1), pool(capacity, key_count) {}
+
+    static const char* name() { return "LRU"; }
+
+    // Hint that the key is about to be accessed
+    void prefetch(long long key) const { pool.prefetch(key); }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("cached", static_cast<long long>(recency.size));
+    }
+
+    // Capacity and the recency list (see Snapshot.h)
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(capacity);
+        pool.saveList(out, recency);
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t saved_capacity;
+        if (!in.getSize(saved_capacity, capacity) || saved_capacity != capacity) return false;
+        return pool.loadList(in, recency, capacity);
+    }
+
+    // Access an offset; returns true on a hit
+    bool access(long long offset, OpType) {
+        if (capacity == 0) return false;
+
+        uint32_t node = pool.find(offset);
+        if (node != NO_NODE) {
+            // Cache hit: move to the most recently used position
+            pool.moveToFront(recency, node);
+            return true;
+        }
+
+        // Cache miss: evict the least recently used entry if the cache is full
+        if (recency.size == capacity) {
+            uint32_t evicted = recency.tail;
+            pool.unlink(recency, evicted);
+            pool.erase(evicted);
+        }
+        pool.pushFront(recency, pool.insert(offset));
+        return false;
+    }
+};
+
+using LRU_Cache = BasicLRUCache<NodePool>;
+using DenseLRU_Cache = BasicLRUCache<DenseNodePool>;
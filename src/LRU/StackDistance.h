@@ -0,0 +1,165 @@
+#pragma once
+
+// Mattson stack-distance analysis for LRU.
+//
+// LRU is a stack algorithm: a request hits in a cache of size C exactly when
+// its stack (reuse) distance, the number of distinct offsets touched since
+// the previous request to the same offset including itself, is at most C.
+// One pass that records the distance of every request therefore gives the
+// hit counts of every cache size at once.
+//
+// Distances are computed with a Fenwick tree indexed by access time: each
+// offset keeps a mark at the time of its latest access, so the distance is
+// the number of marks after that time plus one. Every request costs
+// O(log n). Times are renumbered when the tree fills up, which keeps its size
+// proportional to the number of distinct offsets.
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../Common/CacheStats.h"
+#include "../Common/TraceRecord.h"
+
+// Stack distance of each access, O(log n) per request
+class StackDistanceTracker {
+private:
+    std::vector<int32_t> tree;                          // Fenwick tree over access times
+    std::unordered_map<long long, uint32_t> last_access;
+    uint32_t now = 0;
+    uint32_t marked = 0;
+
+    void add(uint32_t position, int32_t delta) {
+        for (size_t i = position + 1; i < tree.size(); i += i & (~i + 1)) tree[i] += delta;
+    }
+
+    // Number of marks at positions [0, position]
+    uint32_t prefix(uint32_t position) const {
+        int64_t sum = 0;
+        for (size_t i = position + 1; i > 0; i -= i & (~i + 1)) sum += tree[i];
+        return static_cast<uint32_t>(sum);
+    }
+
+    // Renumber the latest access times to 0..n-1 and rebuild the tree
+    void compact() {
+        std::vector<std::pair<uint32_t, long long> > order;
+        order.reserve(last_access.size());
+        for (const auto& entry : last_access) order.push_back({entry.second, entry.first});
+        std::sort(order.begin(), order.end());
+
+        size_t size = std::max<size_t>(1024, tree.size() - 1);
+        while (size < 2 * order.size()) size *= 2;
+        tree.assign(size + 1, 0);
+        for (uint32_t i = 0; i < order.size(); i++) {
+            last_access[order[i].second] = i;
+            tree[i + 1] = 1;
+        }
+        // Linear-time Fenwick construction
+        for (size_t i = 1; i < tree.size(); i++) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent < tree.size()) tree[parent] += tree[i];
+        }
+        now = static_cast<uint32_t>(order.size());
+    }
+
+public:
+    StackDistanceTracker() : tree(1025, 0) {}
+
+    // Record one access; returns its stack distance, or 0 for a first reference
+    size_t access(long long offset) {
+        if (now + 1 >= tree.size()) compact();
+
+        size_t distance = 0;
+        auto it = last_access.find(offset);
+        if (it == last_access.end()) {
+            last_access.emplace(offset, now);
+            marked++;
+        } else {
+            distance = marked - prefix(it->second) + 1;
+            add(it->second, -1);
+            it->second = now;
+        }
+        add(now, 1);
+        now++;
+        return distance;
+    }
+
+    // Forget an offset, as if it had never been accessed
+    void remove(long long offset) {
+        auto it = last_access.find(offset);
+        if (it == last_access.end()) return;
+        add(it->second, -1);
+        marked--;
+        last_access.erase(it);
+    }
+
+    size_t size() const { return last_access.size(); }
+};
+
+class StackDistanceAnalyzer {
+private:
+    StackDistanceTracker tracker;
+
+    // Distance histograms indexed by stack distance (index 0 unused)
+    std::vector<long long> read_histogram;
+    std::vector<long long> write_histogram;
+    long long cold_reads = 0;
+    long long cold_writes = 0;
+
+    static void count(std::vector<long long>& histogram, size_t distance) {
+        if (histogram.size() <= distance) histogram.resize(std::max(distance + 1, histogram.size() * 2), 0);
+        histogram[distance]++;
+    }
+
+public:
+    // Record one request; returns its stack distance, or 0 for a first reference
+    size_t access(long long offset, OpType type) {
+        size_t distance = tracker.access(offset);
+        if (distance == 0) {
+            if (type == OpType::Read) cold_reads++;
+            else cold_writes++;
+        } else {
+            count(type == OpType::Read ? read_histogram : write_histogram, distance);
+        }
+        return distance;
+    }
+
+    size_t getDistinctOffsets() const { return tracker.size(); }
+
+    // Statistics of LRU caches holding each of `capacities` offsets, in the same order
+    std::vector<CacheStats> statsForCapacities(const std::vector<size_t>& capacities) const {
+        std::vector<size_t> order(capacities.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return capacities[a] < capacities[b]; });
+
+        long long reads = cold_reads, writes = cold_writes;
+        for (long long n : read_histogram) reads += n;
+        for (long long n : write_histogram) writes += n;
+
+        // Walk the histograms once, accumulating hits up to each capacity
+        std::vector<CacheStats> result(capacities.size());
+        long long read_hits = 0, write_hits = 0;
+        size_t d = 1;
+        for (size_t i : order) {
+            for (; d <= capacities[i]; d++) {
+                if (d < read_histogram.size()) read_hits += read_histogram[d];
+                if (d < write_histogram.size()) write_hits += write_histogram[d];
+                if (d >= read_histogram.size() && d >= write_histogram.size()) break;
+            }
+            CacheStats& stats = result[i];
+            stats.total_reads = reads;
+            stats.total_writes = writes;
+            stats.total_requests = reads + writes;
+            stats.total_read_hits = read_hits;
+            stats.total_write_hits = write_hits;
+            stats.total_hits = read_hits + write_hits;
+            stats.total_read_misses = reads - read_hits;
+            stats.total_write_misses = writes - write_hits;
+            stats.total_misses = stats.total_read_misses + stats.total_write_misses;
+            stats.cold_misses = cold_reads + cold_writes;
+        }
+        return result;
+    }
+};
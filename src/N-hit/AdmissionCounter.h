@@ -0,0 +1,236 @@
+#pragma once
+
+// Access counters that decide N-hit admission.
+//
+// A counter provides
+//     int increment(long long key);   // count the access, return the new count
+//     size_t memoryBytes() const;     // current footprint
+//     template <class Report>
+//     void reportState(Report&, size_t cached) const;   // see Metrics.h
+//     template <class Writer> void saveState(Writer&) const;   // see Snapshot.h
+//     template <class Reader> bool loadState(Reader&);
+// ExactAccessCounter keeps one entry per offset ever seen. SketchAccessCounter
+// estimates the counts within a fixed memory budget. DenseAccessCounter is
+// ExactAccessCounter for dense key ids (see DenseKeys.h), an array indexed
+// by id and sized for every id up front.
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ExactAccessCounter {
+private:
+    std::unordered_map<long long, int> access_counts;
+
+public:
+    static const char* policyName() { return "N-hit"; }
+
+    int increment(long long key) { return ++access_counts[key]; }
+
+    // Offsets with a count that are not cached (every cached offset has one)
+    template <class Report>
+    void reportState(Report& report, size_t cached) const {
+        report("pending_counts", static_cast<long long>(access_counts.size() - cached));
+    }
+
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(access_counts.size());
+        for (const auto& entry : access_counts) {
+            out.putI64(entry.first);
+            out.putI64(entry.second);
+        }
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t count;
+        if (!in.getSize(count, in.remaining() / 2)) return false;
+        access_counts.clear();
+        access_counts.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            long long key, value;
+            if (!in.getI64(key) || !in.getI64(value) || value <= 0 || value > INT32_MAX) return false;
+            access_counts[key] = static_cast<int>(value);
+        }
+        return access_counts.size() == count;
+    }
+
+    // Approximate: node (next pointer, key/value, cached hash) plus bucket array
+    size_t memoryBytes() const {
+        return access_counts.size() * (sizeof(void*) + sizeof(std::pair<const long long, int>) + sizeof(size_t))
+               + access_counts.bucket_count() * sizeof(void*);
+    }
+};
+
+class DenseAccessCounter {
+private:
+    std::vector<int> access_counts;
+    size_t counted = 0;     // Keys with a non-zero count
+
+public:
+    // key_count is the number of dense ids from assignDenseKeys
+    explicit DenseAccessCounter(size_t key_count) : access_counts(key_count, 0) {}
+
+    static const char* policyName() { return "N-hit"; }
+
+    size_t keyCount() const { return access_counts.size(); }
+
+    int increment(long long key) {
+        int& count = access_counts[static_cast<size_t>(key)];
+        if (count == 0) counted++;
+        return ++count;
+    }
+
+    template <class Report>
+    void reportState(Report& report, size_t cached) const {
+        report("pending_counts", static_cast<long long>(counted - cached));
+    }
+
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(access_counts.size());
+        for (int count : access_counts) out.putI64(count);
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t size;
+        if (!in.getSize(size, in.remaining()) || size != access_counts.size()) return false;
+        counted = 0;
+        for (int& count : access_counts) {
+            long long value;
+            if (!in.getI64(value) || value < 0 || value > INT32_MAX) return false;
+            count = static_cast<int>(value);
+            if (count > 0) counted++;
+        }
+        return true;
+    }
+
+    size_t memoryBytes() const { return access_counts.capacity() * sizeof(int); }
+};
+
+// Count-min sketch of 8-bit saturating counters behind a TinyLFU-style
+// doorkeeper. The first access of an offset only sets its bits in the
+// doorkeeper Bloom filter, so one-hit offsets never reach the sketch. After
+// every `sample_size` increments all counters are halved and the doorkeeper
+// is cleared, so old popularity fades. A quarter of the budget goes to the
+// doorkeeper and the rest to the sketch rows.
+class SketchAccessCounter {
+private:
+    static constexpr int DEPTH = 4;
+    static constexpr int DOORKEEPER_HASHES = 2;
+
+    std::vector<uint8_t> counters;     // DEPTH rows of `width` counters
+    std::vector<uint64_t> doorkeeper;  // Bloom filter bits
+    size_t width;
+    uint64_t doorkeeper_mask;
+    long long sample_size;
+    long long increments = 0;
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // The i-th hash of a key from two base hashes (Kirsch & Mitzenmacher)
+    static uint64_t nthHash(uint64_t h, int i) { return h + static_cast<uint64_t>(i) * ((h >> 32) | 1); }
+
+    bool inDoorkeeper(uint64_t h) const {
+        for (int i = 0; i < DOORKEEPER_HASHES; i++) {
+            uint64_t bit = nthHash(h, DEPTH + i) & doorkeeper_mask;
+            if (!(doorkeeper[bit >> 6] & (1ULL << (bit & 63)))) return false;
+        }
+        return true;
+    }
+
+    void addToDoorkeeper(uint64_t h) {
+        for (int i = 0; i < DOORKEEPER_HASHES; i++) {
+            uint64_t bit = nthHash(h, DEPTH + i) & doorkeeper_mask;
+            doorkeeper[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+
+    uint8_t& counter(uint64_t h, int row) { return counters[row * width + (nthHash(h, row) & (width - 1))]; }
+
+    void age() {
+        for (uint8_t& c : counters) c >>= 1;
+        std::fill(doorkeeper.begin(), doorkeeper.end(), 0);
+        increments = 0;
+    }
+
+    static size_t floorPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p * 2 <= n) p *= 2;
+        return p;
+    }
+
+public:
+    explicit SketchAccessCounter(size_t budget_bytes) {
+        budget_bytes = std::max<size_t>(budget_bytes, 64);
+        size_t doorkeeper_bits = floorPowerOfTwo(std::max<size_t>(64, budget_bytes / 4 * 8));
+        width = floorPowerOfTwo(std::max<size_t>(1, (budget_bytes - doorkeeper_bits / 8) / DEPTH));
+        counters.assign(DEPTH * width, 0);
+        doorkeeper.assign(doorkeeper_bits / 64, 0);
+        doorkeeper_mask = doorkeeper_bits - 1;
+        sample_size = 10 * static_cast<long long>(width);
+    }
+
+    static const char* policyName() { return "N-hit-CMS"; }
+
+    int increment(long long key) {
+        uint64_t h = mix(static_cast<uint64_t>(key));
+        if (++increments >= sample_size) age();
+
+        if (!inDoorkeeper(h)) {
+            addToDoorkeeper(h);
+            return 1;
+        }
+
+        // Conservative update: raise only the counters at the current minimum
+        uint8_t estimate = UINT8_MAX;
+        for (int row = 0; row < DEPTH; row++) estimate = std::min(estimate, counter(h, row));
+        if (estimate < UINT8_MAX) {
+            for (int row = 0; row < DEPTH; row++) {
+                uint8_t& c = counter(h, row);
+                if (c == estimate) c++;
+            }
+            estimate++;
+        }
+        return 1 + estimate;
+    }
+
+    size_t memoryBytes() const { return counters.size() + doorkeeper.size() * sizeof(uint64_t); }
+
+    // The sketch and doorkeeper as raw bytes, in host byte order
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(width);
+        out.putU64(doorkeeper.size());
+        out.putI64(increments);
+        out.putBytes(counters.data(), counters.size());
+        out.putBytes(doorkeeper.data(), doorkeeper.size() * sizeof(uint64_t));
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t saved_width, doorkeeper_words;
+        if (!in.getSize(saved_width, width) || saved_width != width) return false;
+        if (!in.getSize(doorkeeper_words, doorkeeper.size()) || doorkeeper_words != doorkeeper.size()) return false;
+        if (!in.getI64(increments) || increments < 0 || increments >= sample_size) return false;
+        return in.getBytes(counters.data(), counters.size())
+               && in.getBytes(doorkeeper.data(), doorkeeper.size() * sizeof(uint64_t));
+    }
+
+    // Counts are not kept per offset; report progress towards the next aging
+    template <class Report>
+    void reportState(Report& report, size_t) const {
+        report("increments_since_aging", increments);
+    }
+};
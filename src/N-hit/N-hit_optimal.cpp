@@ -1,172 +1,59 @@
+#include <chrono>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <set>
-
-struct Request {
-    long long timestamp;
-    std::string logical_address;
-    std::string request_type;
-};
-
-struct CacheItem {
-    std::string logical_address;
-    int access_count;
-    long long insertion_time;
-
-    // Comparator for std::set
-    bool operator<(const CacheItem& other) const {
-        if (access_count == other.access_count) {
-            return insertion_time < other.insertion_time; // FIFO if access counts are equal
-        }
-        return access_count < other.access_count; // Evict least accessed first
-    }
-};
-
-class NHitCache {
-private:
-    int cache_size;
-    int insertion_threshold;
-    long long start_time, end_time;
-    std::unordered_map<std::string, CacheItem> cache;
-    std::unordered_map<std::string, int> access_counts;
-    
-    std::set<CacheItem> eviction_set;
-
-    // Metrics
-    int total_read_hit = 0, total_read_miss = 0;
-    int total_write_hit = 0, total_write_miss = 0;
-    int total_read_requests = 0, total_write_requests = 0;
-    int total_cold_miss = 0;
-
-public:
-    NHitCache(int size, int threshold, long long start, long long end)
-        : cache_size(size), insertion_threshold(threshold), start_time(start), end_time(end) {}
-
-    void process_request(const Request& request) {
-        if (request.timestamp < start_time || request.timestamp > end_time) {
-            return;
-        }
-
-        if (request.request_type == "Read") {
-            total_read_requests++;
-        } else if (request.request_type == "Write") {
-            total_write_requests++;
-        }
-
-        auto it = cache.find(request.logical_address);
-
-        if (it != cache.end()) {
-            // Cache hit
-            access_counts[it->first]++;
-
-            CacheItem old_item = it->second;
-            eviction_set.erase(old_item); // Remove old item from the set
 
-            it->second.access_count++; // Update access count
-            CacheItem updated_item = it->second;
-            eviction_set.insert(updated_item); // Insert updated item into the set
-
-
-            if (request.request_type == "Read") {
-                total_read_hit++;
-            } else {
-                total_write_hit++;
-            }
-        } else {
-            // Cache miss
-            if (request.request_type == "Read") {
-                total_read_miss++;
-            } else {
-                total_write_miss++;
-            }
-
-            if(access_counts[request.logical_address] == 0){ // first miss
-                total_cold_miss += 1;
-            }
-            access_counts[request.logical_address]++;
-
-            if (access_counts[request.logical_address] >= insertion_threshold) {
-                if (cache.size() >= static_cast<size_t>(cache_size)) {
-                    evict();
-                }
-                CacheItem item = { request.logical_address, access_counts[request.logical_address], request.timestamp };
-                cache[request.logical_address] = item;
-                eviction_set.insert(item);
-            }
-            
-        }
-    }
-
-    void evict() {
-        // Evict the least accessed item (minimum item in the set)
-        if (!eviction_set.empty()) {
-            CacheItem to_evict = *eviction_set.begin(); // Get the minimum item
-            eviction_set.erase(eviction_set.begin()); // Remove it from the set
-            cache.erase(to_evict.logical_address);   // Remove it from the cache
-        }
-    }
-
-    void print_metrics() const {
-        int total_requests = total_read_requests + total_write_requests;
-        int total_cache_hit = total_read_hit + total_write_hit;
-        int total_cache_miss = total_read_miss + total_write_miss;
-
-        std::cout << "Total Read Hit: " << total_read_hit << "\n";
-        std::cout << "Total Read Miss: " << total_read_miss << "\n";
-        std::cout << "Total Write Hit: " << total_write_hit << "\n";
-        std::cout << "Total Write Miss: " << total_write_miss << "\n";
-        std::cout << "Total Read Requests: " << total_read_requests << "\n";
-        std::cout << "Total Write Requests: " << total_write_requests << "\n";
-        std::cout << "Total Requests: " << total_requests << "\n";
-        std::cout << "Total Cache Hit: " << total_cache_hit << "\n";
-        std::cout << "Total Cache Miss: " << total_cache_miss << "\n";
-        std::cout << "Total Cold Miss: " << total_cold_miss << "\n";
-
-        double hit_ratio = total_requests > 0 ? static_cast<double>(total_cache_hit) / total_requests : 0.0;
-        double miss_ratio = total_requests > 0 ? static_cast<double>(total_cache_miss) / total_requests : 0.0;
-
-        std::cout << "Hit Ratio: " << hit_ratio << "\n";
-        std::cout << "Miss Ratio: " << miss_ratio << "\n";
-    }
-};
-
-void process_csv(const std::string& filename, NHitCache& cache) {
-    std::ifstream file(filename);
-    std::string line;
-
-    long long first_request_time = -1;
-
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string field;
-
-        Request req;
-        std::getline(ss, field, ',');
-        req.timestamp = std::stoll(field);
-
-        if (first_request_time == -1) {
-            first_request_time = req.timestamp;
-        }
-
-        req.timestamp -= first_request_time; // Normalize timestamp relative to the first request
-
-        std::getline(ss, field, ','); // Skip second field
-        std::getline(ss, field, ',');
-        req.logical_address = field;
-
-        std::getline(ss, field, ','); // Skip fourth field
-        std::getline(ss, field, ',');
-        req.request_type = field;
+#include "NHitCache.h"
+#include "../Common/Simulation.h"
+
+void print_metrics(const CacheStats& stats) {
+    long long total_requests = stats.total_requests;
+    long long total_cache_hit = stats.total_hits;
+    long long total_cache_miss = stats.total_misses;
+
+    std::cout << "Total Read Hit: " << stats.total_read_hits << "\n";
+    std::cout << "Total Read Miss: " << stats.total_read_misses << "\n";
+    std::cout << "Total Write Hit: " << stats.total_write_hits << "\n";
+    std::cout << "Total Write Miss: " << stats.total_write_misses << "\n";
+    std::cout << "Total Read Requests: " << stats.total_reads << "\n";
+    std::cout << "Total Write Requests: " << stats.total_writes << "\n";
+    std::cout << "Total Requests: " << total_requests << "\n";
+    std::cout << "Total Cache Hit: " << total_cache_hit << "\n";
+    std::cout << "Total Cache Miss: " << total_cache_miss << "\n";
+    std::cout << "Total Cold Miss: " << stats.cold_misses << "\n";
+
+    double hit_ratio = total_requests > 0 ? static_cast<double>(total_cache_hit) / total_requests : 0.0;
+    double miss_ratio = total_requests > 0 ? static_cast<double>(total_cache_miss) / total_requests : 0.0;
+
+    std::cout << "Hit Ratio: " << hit_ratio << "\n";
+    std::cout << "Miss Ratio: " << miss_ratio << "\n";
+}
 
-        cache.process_request(req);
-    }
+// Simulate already loaded requests and return the elapsed time in seconds
+template <class Cache>
+double timed_run(Cache& cache, const std::vector<TraceRecord>& records, CacheStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    simulateRecords(records, cache, stats);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
-int main() {
+// With no arguments the program uses exact access counts; --sketch uses a
+// count-min sketch, and --compare runs both over the same window
+int main(int argc, char* argv[]) {
     std::string filename;
-    int cache_size, insertion_threshold;
+    int mode = 1, cache_size, insertion_threshold;
     long long start_time, end_time;
+    size_t budget_kb = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--sketch") {
+            mode = 2;
+        } else if (flag == "--compare") {
+            mode = 3;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sketch | --compare]" << std::endl;
+            return 1;
+        }
+    }
 
     std::cout << "Enter CSV filename: ";
     std::cin >> filename;
@@ -177,19 +64,56 @@ int main() {
     std::cout << "Enter insertion threshold (N-hit): ";
     std::cin >> insertion_threshold;
 
+    if (mode == 2 || mode == 3) {
+        std::cout << "Enter sketch memory budget (KB): ";
+        std::cin >> budget_kb;
+    }
+
     std::cout << "Enter start time (relative, in seconds): ";
     std::cin >> start_time;
 
     std::cout << "Enter end time (relative, in seconds): ";
     std::cin >> end_time;
 
-    start_time *= 1000000000; // Convert to nanoseconds
-    end_time *= 1000000000;
+    TimeWindow window = windowFromSeconds(start_time, end_time);
+
+    if (mode == 3) {
+        // Load the window once so both runs time only the policy
+        std::vector<TraceRecord> records;
+        if (!loadTraceWindow(filename, window, records)) return 1;
+
+        NHitCache exact(cache_size, insertion_threshold);
+        SketchNHitCache sketch(cache_size, insertion_threshold, budget_kb * 1024);
+        CacheStats exact_stats, sketch_stats;
+        double exact_seconds = timed_run(exact, records, exact_stats);
+        double sketch_seconds = timed_run(sketch, records, sketch_stats);
+
+        std::cout << "Exact counts:\n";
+        print_metrics(exact_stats);
+        std::cout << "\nCount-min sketch:\n";
+        print_metrics(sketch_stats);
+        std::cout << "\nHit Ratio Difference (sketch - exact): "
+                  << (sketch_stats.hitRate() - exact_stats.hitRate()) / 100.0 << "\n";
+        std::cout << "Counter Memory (bytes): exact " << exact.getCounter().memoryBytes()
+                  << ", sketch " << sketch.getCounter().memoryBytes() << "\n";
+        std::cout << "Simulation Time (s): exact " << exact_seconds << ", sketch " << sketch_seconds << "\n";
+        return 0;
+    }
 
-    NHitCache cache(cache_size, insertion_threshold, start_time, end_time);
-    process_csv(filename, cache);
+    CacheStats stats;
+    bool ok;
+    if (mode == 2) {
+        SketchNHitCache cache(cache_size, insertion_threshold, budget_kb * 1024);
+        ok = simulateTrace(filename, window, cache, stats);
+    } else {
+        NHitCache cache(cache_size, insertion_threshold);
+        ok = simulateTrace(filename, window, cache, stats);
+    }
+    if (!ok) {
+        return 1;
+    }
 
-    cache.print_metrics();
+    print_metrics(stats);
 
     return 0;
 }
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "AdmissionCounter.h"
+#include "../Common/NodePool.h"
+#include "../Common/TraceRecord.h"
+
+// Dense ids the pool indexes: those of a DenseAccessCounter; hashed pools
+// take any key
+template <class Counter>
+size_t denseKeyCount(const Counter&) { return 0; }
+inline size_t denseKeyCount(const DenseAccessCounter& counter) { return counter.keyCount(); }
+
+// Admits an offset only after it has been accessed insertion_threshold times
+// and evicts the least accessed item, oldest insertion first. Access counts
+// come from Counter (see AdmissionCounter.h).
+//
+// Items live in a NodePool and are grouped into frequency buckets kept in a
+// list sorted by count, so the victim is the oldest item of the first bucket.
+// A bucket keeps its items ordered by insertion time, newest at the head, and
+// takes an item at either end in O(1). An item that belongs in the middle is
+// parked on the bucket's unsorted pending list instead, and the pending items
+// are sorted and merged in only when the bucket is next evicted from. A hit
+// is therefore O(1) and never allocates. Admitting an item walks the bucket
+// list to its count from whichever end is nearer in count: O(1) for a count
+// at or beyond either end, but O(#buckets) in the worst case for one in the
+// middle. Pool is NodePool for raw offsets or DenseNodePool for dense key ids
+// (see DenseKeys.h).
+template <class Counter, class Pool = NodePool>
+class BasicNHitCache {
+private:
+    struct Bucket {
+        int count;
+        NodeList items;     // Sorted by insertion time, newest at the head
+        NodeList pending;   // Not yet merged into items
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    size_t capacity;
+    int insertion_threshold;
+    long long insertion_clock = 0;  // Orders insertions for FIFO tie-breaking
+    Counter access_counts;
+
+    Pool pool;
+    std::vector<long long> inserted_at;   // Insertion time of each node
+    std::vector<uint32_t> bucket_of;      // Bucket of each node
+    std::vector<uint8_t> is_pending;      // Node is on its bucket's pending list
+    std::vector<Bucket> buckets;          // At most one per cached item
+    std::vector<uint32_t> free_buckets;
+    uint32_t first_bucket = NO_NODE;      // Lowest count
+    uint32_t last_bucket = NO_NODE;       // Highest count
+    size_t cached = 0;
+    std::vector<uint32_t> merge_scratch;  // Reserved for the capacity
+
+    // Add an empty bucket for `count` after `after` (NO_NODE for the front)
+    uint32_t addBucket(int count, uint32_t after) {
+        uint32_t b = free_buckets.back();
+        free_buckets.pop_back();
+        uint32_t next = after != NO_NODE ? buckets[after].next : first_bucket;
+        buckets[b] = Bucket{count, NodeList(), NodeList(), after, next};
+        if (after != NO_NODE) buckets[after].next = b;
+        else first_bucket = b;
+        if (next != NO_NODE) buckets[next].prev = b;
+        else last_bucket = b;
+        return b;
+    }
+
+    void removeBucketIfEmpty(uint32_t b) {
+        if (buckets[b].items.size + buckets[b].pending.size > 0) return;
+        if (buckets[b].prev != NO_NODE) buckets[buckets[b].prev].next = buckets[b].next;
+        else first_bucket = buckets[b].next;
+        if (buckets[b].next != NO_NODE) buckets[buckets[b].next].prev = buckets[b].prev;
+        else last_bucket = buckets[b].prev;
+        free_buckets.push_back(b);
+    }
+
+    // Place the node in bucket b
+    void link(uint32_t b, uint32_t node) {
+        NodeList& items = buckets[b].items;
+        bucket_of[node] = b;
+        is_pending[node] = 0;
+        if (items.head == NO_NODE || inserted_at[node] > inserted_at[items.head]) {
+            pool.pushFront(items, node);
+        } else if (inserted_at[node] < inserted_at[items.tail]) {
+            pool.insertBefore(items, NO_NODE, node);
+        } else {
+            pool.pushFront(buckets[b].pending, node);
+            is_pending[node] = 1;
+        }
+    }
+
+    void unlink(uint32_t node) {
+        Bucket& bucket = buckets[bucket_of[node]];
+        pool.unlink(is_pending[node] ? bucket.pending : bucket.items, node);
+    }
+
+    // Sort bucket b's pending items and merge them into its items, walking
+    // up from the oldest end
+    void mergePending(uint32_t b) {
+        NodeList& items = buckets[b].items;
+        NodeList& pending = buckets[b].pending;
+        merge_scratch.clear();
+        for (uint32_t node = pending.head; node != NO_NODE; node = pool.next(node)) merge_scratch.push_back(node);
+        pending = NodeList();
+        std::sort(merge_scratch.begin(), merge_scratch.end(),
+                  [this](uint32_t x, uint32_t y) { return inserted_at[x] < inserted_at[y]; });
+
+        uint32_t newer = items.tail;
+        for (uint32_t node : merge_scratch) {
+            while (newer != NO_NODE && inserted_at[newer] < inserted_at[node]) newer = pool.prev(newer);
+            pool.insertBefore(items, newer != NO_NODE ? pool.next(newer) : items.head, node);
+            is_pending[node] = 0;
+        }
+    }
+
+public:
+    template <class... CounterArgs>
+    BasicNHitCache(int size, int threshold, CounterArgs&&... counter_args)
+        : capacity(size > 1 ? size : 1), insertion_threshold(threshold),
+          access_counts(std::forward<CounterArgs>(counter_args)...), pool(capacity, denseKeyCount(access_counts)),
+          inserted_at(capacity), bucket_of(capacity), is_pending(capacity), buckets(capacity + 1) {
+        merge_scratch.reserve(capacity);
+        for (uint32_t b = static_cast<uint32_t>(buckets.size()); b-- > 0;) free_buckets.push_back(b);
+    }
+
+    static const char* name() { return Counter::policyName(); }
+
+    // Hint that the key is about to be accessed
+    void prefetch(long long key) const { pool.prefetch(key); }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("cached", static_cast<long long>(cached));
+        report("buckets", static_cast<long long>(buckets.size() - free_buckets.size()));
+        access_counts.reportState(report, cached);
+    }
+
+    // Parameters, access counts and the cached items with their counts and
+    // insertion times, bucket by bucket (see Snapshot.h)
+    template <class Writer>
+    void saveState(Writer& out) const {
+        out.putU64(capacity);
+        out.putI64(insertion_threshold);
+        out.putI64(insertion_clock);
+        access_counts.saveState(out);
+        out.putU64(buckets.size() - free_buckets.size());
+        for (uint32_t b = first_bucket; b != NO_NODE; b = buckets[b].next) {
+            out.putI64(buckets[b].count);
+            out.putU64(buckets[b].items.size + buckets[b].pending.size);
+            for (const NodeList* list : {&buckets[b].items, &buckets[b].pending}) {
+                for (uint32_t node = list->head; node != NO_NODE; node = pool.next(node)) {
+                    out.putI64(pool.key(node));
+                    out.putI64(inserted_at[node]);
+                }
+            }
+        }
+    }
+
+    template <class Reader>
+    bool loadState(Reader& in) {
+        size_t saved_capacity, bucket_count;
+        long long threshold;
+        if (!in.getSize(saved_capacity, capacity) || saved_capacity != capacity) return false;
+        if (!in.getI64(threshold) || threshold != insertion_threshold) return false;
+        if (!in.getI64(insertion_clock) || !access_counts.loadState(in)) return false;
+        if (!in.getSize(bucket_count, capacity)) return false;
+
+        // Linking each bucket's items oldest first keeps them all sorted
+        std::vector<std::pair<long long, long long>> items;   // Insertion time, key
+        uint32_t last = NO_NODE;
+        for (size_t i = 0; i < bucket_count; i++) {
+            long long count;
+            size_t size;
+            if (!in.getI64(count) || !in.getSize(size, capacity - cached) || size == 0) return false;
+            if (count > INT32_MAX || (last != NO_NODE && count <= buckets[last].count)) return false;
+            items.resize(size);
+            for (auto& item : items) {
+                if (!in.getI64(item.second) || !in.getI64(item.first)) return false;
+            }
+            std::sort(items.begin(), items.end());
+
+            last = addBucket(static_cast<int>(count), last);
+            for (const auto& item : items) {
+                if (pool.find(item.second) != NO_NODE) return false;
+                uint32_t node = pool.insert(item.second);
+                inserted_at[node] = item.first;
+                cached++;
+                link(last, node);
+            }
+        }
+        return true;
+    }
+
+    // Access an offset; returns true on a hit
+    bool access(long long logical_address, OpType) {
+        uint32_t node = pool.find(logical_address);
+
+        if (node != NO_NODE) {
+            // Cache hit: move to the bucket for count + 1
+            access_counts.increment(logical_address);
+
+            uint32_t b = bucket_of[node];
+            int count = buckets[b].count + 1;
+            uint32_t target = buckets[b].next;
+            if (target == NO_NODE || buckets[target].count != count) target = addBucket(count, b);
+            unlink(node);
+            link(target, node);
+            removeBucketIfEmpty(b);
+            return true;
+        }
+
+        // Cache miss
+        int count = access_counts.increment(logical_address);
+
+        if (count >= insertion_threshold) {
+            if (cached >= capacity) {
+                evict();
+            }
+            node = pool.insert(logical_address);
+            cached++;
+            inserted_at[node] = insertion_clock++;
+
+            // Find the last bucket with at most the admission count, walking
+            // from the nearer end
+            uint32_t prev = NO_NODE;
+            if (first_bucket != NO_NODE && count >= buckets[first_bucket].count) {
+                if (count - buckets[first_bucket].count <= buckets[last_bucket].count - count) {
+                    prev = first_bucket;
+                    while (buckets[prev].next != NO_NODE && buckets[buckets[prev].next].count <= count) {
+                        prev = buckets[prev].next;
+                    }
+                } else {
+                    prev = last_bucket;
+                    while (buckets[prev].count > count) prev = buckets[prev].prev;
+                }
+            }
+            uint32_t b = prev != NO_NODE && buckets[prev].count == count ? prev : addBucket(count, prev);
+            link(b, node);
+        }
+        return false;
+    }
+
+    void evict() {
+        // Evict the least accessed item, oldest first
+        if (first_bucket == NO_NODE) return;
+        uint32_t b = first_bucket;
+        if (buckets[b].pending.size > 0) mergePending(b);
+        uint32_t node = buckets[b].items.tail;
+        pool.unlink(buckets[b].items, node);
+        pool.erase(node);
+        cached--;
+        removeBucketIfEmpty(b);
+    }
+
+    const Counter& getCounter() const { return access_counts; }
+};
+
+using NHitCache = BasicNHitCache<ExactAccessCounter>;
+using SketchNHitCache = BasicNHitCache<SketchAccessCounter>;
+using DenseNHitCache = BasicNHitCache<DenseAccessCounter, DenseNodePool>;
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../Common/TraceColumns.h"
+
+// Both Belady classes and computeNextUse store request positions in 32 bits,
+// so a sequence may hold at most this many requests
+const size_t BELADY_MAX_REQUESTS = (size_t(1) << 31) - 1;
+
+// Returns false, with an error, if a sequence is too long for Belady
+inline bool checkBeladySequence(size_t requests) {
+    if (requests <= BELADY_MAX_REQUESTS) return true;
+    std::cerr << "Error: Belady supports at most " << BELADY_MAX_REQUESTS << " requests, the window has "
+              << requests << std::endl;
+    return false;
+}
+
+// Custom comparator to sort cache by decreasing "next use" time
+struct CompareNextUse {
+    bool operator()(const std::pair<int, long long int> &a, const std::pair<int, long long int> &b) const {
+        return a.first > b.first;  // Sort by "next use" time in descending order
+    }
+};
+
+// Belady's optimal replacement with bypass. The policy needs the future, so it
+// is built over the whole request sequence and access() must then be called
+// for those requests in order. Future occurrences are computed separately for
+// each of piece_count pieces of the sequence to bound memory use.
+class BeladyCache {
+private:
+    size_t cache_size;
+    int piece_count;
+    OffsetView sequence;
+    size_t cursor = 0;
+    size_t piece_end = 0;
+    long long out_misses = 0;
+
+    std::unordered_map<long long int, std::vector<int> > future_occurrences;
+    std::multiset<std::pair<int, long long int>, CompareNextUse> cache;  // Cache uses a custom comparator for decreasing order
+    std::unordered_map<long long int, std::multiset<std::pair<int, long long int> >::iterator> cache_map;  // Map storing iterators to set elements
+
+    // Preprocess future occurrences of pages in the piece starting at cursor
+    void preparePiece() {
+        size_t piece_length = (sequence.size() + piece_count - 1) / piece_count;
+        piece_end = std::min(cursor + piece_length, sequence.size());
+        future_occurrences.clear();
+        for (size_t i = piece_end; i-- > cursor;) {
+            future_occurrences[sequence[i]].push_back(static_cast<int>(i));  // Store future occurrence index
+        }
+    }
+
+public:
+    BeladyCache(int size, int pieces, OffsetView requests)
+        : cache_size(size), piece_count(pieces > 0 ? pieces : 1), sequence(requests) {}
+
+    static const char* name() { return "Belady"; }
+
+    // Access the next request of the sequence; returns true on a hit
+    bool access(long long int page, OpType) {
+        if (cursor == piece_end) preparePiece();
+        cursor++;
+
+        std::vector<int>& occurrences = future_occurrences[page];
+        occurrences.pop_back();
+        int next_use = occurrences.empty() ? INT_MAX : occurrences.back();
+
+        auto found = cache_map.find(page);
+        if (found != cache_map.end()) {
+            // Page hit, update next use in the cache
+            cache.erase(found->second);  // Erase the old entry using the iterator
+            found->second = cache.insert({next_use, page});  // Re-insert with updated next_use
+            return true;
+        }
+
+        // Cache miss
+        if (cache.size() == cache_size) {
+            // Evict the page with the biggest "next use" (i.e., the one at the beginning)
+            auto it = cache.begin();
+            if (it->first > next_use) {
+                cache_map.erase(it->second);  // Remove from cache_map
+                cache.erase(it);  // Remove from cache set
+                cache_map[page] = cache.insert({next_use, page});
+            } else {
+                out_misses++;  // Page can't be inserted because its next use is too far
+            }
+        } else {
+            // Cache is not full, insert page directly
+            cache_map[page] = cache.insert({next_use, page});
+        }
+        return false;
+    }
+
+    long long getOutMisses() const { return out_misses; }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("cached", static_cast<long long>(cache.size()));
+        report("bypassed", out_misses);
+    }
+};
+
+// Position of the next request to the same offset, or n + i if there is none,
+// so every value is unique. Returns the number of distinct offsets in
+// `distinct` if it is non-null. The caller checks the length with
+// checkBeladySequence.
+inline std::vector<uint32_t> computeNextUse(OffsetView requests, size_t* distinct = nullptr) {
+    std::vector<uint32_t> next_use(requests.size());
+    std::unordered_map<long long, uint32_t> following;
+    following.reserve(requests.size() / 4);
+    uint32_t n = static_cast<uint32_t>(requests.size());
+    for (uint32_t i = n; i-- > 0;) {
+        auto it = following.find(requests[i]);
+        if (it == following.end()) {
+            next_use[i] = n + i;
+            following.emplace(requests[i], i);
+        } else {
+            next_use[i] = it->second;
+            it->second = i;
+        }
+    }
+    if (distinct != nullptr) *distinct = following.size();
+    return next_use;
+}
+
+// Exact Belady over the whole sequence, for up to BELADY_MAX_REQUESTS requests.
+//
+// Next uses are computed once up front, and since they are unique every
+// position identifies one cached offset. The cache is a lazy max-heap of
+// next-use positions plus a bitmap of the live ones: a hit is live[i], and
+// heap entries invalidated by hits are skipped when they reach the top. No
+// per-offset map is kept while simulating.
+class ExactBeladyCache {
+private:
+    size_t cache_size;
+    std::vector<uint32_t> next_use;
+    std::vector<bool> live;          // live[p]: a cached offset is next used at p
+    std::vector<uint32_t> heap;      // Max-heap of next-use positions, may hold stale entries
+    size_t cached = 0;
+    size_t cursor = 0;
+    long long out_misses = 0;
+
+    // Drop stale entries once they outnumber the live ones
+    void compactHeap() {
+        heap.erase(std::remove_if(heap.begin(), heap.end(), [&](uint32_t p) { return !live[p]; }), heap.end());
+        std::make_heap(heap.begin(), heap.end());
+    }
+
+    void push(uint32_t position) {
+        live[position] = true;
+        heap.push_back(position);
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > 2 * cache_size + 1024) compactHeap();
+    }
+
+public:
+    ExactBeladyCache(int size, OffsetView requests)
+        : cache_size(size > 0 ? size : 0), next_use(computeNextUse(requests)), live(2 * requests.size(), false) {
+        heap.reserve(2 * cache_size + 1024);
+    }
+
+    static const char* name() { return "Belady"; }
+
+    // Access the next request of the sequence; returns true on a hit
+    bool access(long long, OpType) {
+        size_t i = cursor++;
+        uint32_t next = next_use[i];
+
+        if (live[i]) {
+            // Hit: the entry for position i becomes stale, re-key by the next use
+            live[i] = false;
+            push(next);
+            return true;
+        }
+
+        if (cache_size == 0) {
+            out_misses++;
+            return false;
+        }
+        if (cached == cache_size) {
+            while (!live[heap.front()]) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+            // Bypass if the new offset is needed later than everything cached
+            if (heap.front() < next) {
+                out_misses++;
+                return false;
+            }
+            live[heap.front()] = false;
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+            cached--;
+        }
+        push(next);
+        cached++;
+        return false;
+    }
+
+    long long getOutMisses() const { return out_misses; }
+
+    template <class Report>
+    void reportState(Report& report) const {
+        report("cached", static_cast<long long>(cached));
+        report("bypassed", out_misses);
+    }
+};
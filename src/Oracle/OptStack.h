@@ -0,0 +1,137 @@
+#pragma once
+
+// Belady's OPT for many cache sizes in one pass (Mattson et al., 1970).
+//
+// The simulators use OPT with bypass: on a miss, a full cache of size C keeps
+// the C offsets needed soonest among its contents and the new one. This is a
+// stack algorithm with the next use as priority. The accessed offset, with
+// its new next use, is carried down from the top and swaps with every entry
+// that is needed later, until it reaches the slot it occupied (or the bottom
+// on a miss). The top C entries are then exactly the contents of a cache of
+// size C, so a request hits in it when its depth is below C.
+//
+// Entries are identified by their next-use position (see computeNextUse), so
+// the stack is an array of positions with an array from position to depth,
+// and is cut at the largest capacity asked for. The carried value only grows,
+// so blocks whose largest entry is below it are skipped whole. A request
+// costs at most O(depth).
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "BeladyCache.h"
+#include "../Common/CacheStats.h"
+#include "../Common/TraceColumns.h"
+
+class OptStackAnalyzer {
+private:
+    static constexpr uint32_t NOT_IN_STACK = UINT32_MAX;
+    static constexpr size_t BLOCK = 64;
+
+    size_t max_depth;
+    size_t distinct = 0;
+    std::vector<long long> read_histogram;    // Hits by depth
+    std::vector<long long> write_histogram;
+    long long reads = 0;
+    long long writes = 0;
+
+    // type_at(i) is the type of request i
+    template <class TypeAt>
+    void analyze(OffsetView requests, TypeAt type_at) {
+        std::vector<uint32_t> next_use = computeNextUse(requests, &distinct);
+        std::vector<uint32_t> depth_of(2 * requests.size(), NOT_IN_STACK);
+        std::vector<uint32_t> stack;
+        std::vector<uint32_t> block_max;    // Largest entry of each BLOCK-sized block of the stack
+        stack.reserve(max_depth + 1);
+
+        for (size_t i = 0; i < requests.size(); i++) {
+            OpType type = type_at(i);
+            if (type == OpType::Read) reads++;
+            else writes++;
+
+            // Depth of the accessed offset; a miss for every size if it is not in the stack
+            size_t depth = depth_of[i];
+            if (depth != NOT_IN_STACK) {
+                (type == OpType::Read ? read_histogram : write_histogram)[depth]++;
+                depth_of[i] = NOT_IN_STACK;
+            } else {
+                depth = stack.size();
+                stack.push_back(0);
+                if (depth % BLOCK == 0) block_max.push_back(0);
+            }
+
+            // Carry the accessed offset down, keeping the sooner-needed entry higher
+            uint32_t carried = next_use[i];
+            for (size_t start = 0; start < depth; start += BLOCK) {
+                size_t block = start / BLOCK;
+                if (block_max[block] < carried && start + BLOCK <= depth) continue;
+                size_t end = std::min(start + BLOCK, depth);
+                for (size_t d = start; d < end; d++) {
+                    if (stack[d] > carried) {
+                        std::swap(stack[d], carried);
+                        depth_of[stack[d]] = static_cast<uint32_t>(d);
+                    }
+                }
+                if (end == start + BLOCK) {
+                    block_max[block] = *std::max_element(stack.begin() + start, stack.begin() + end);
+                }
+            }
+            stack[depth] = carried;
+            depth_of[carried] = static_cast<uint32_t>(depth);
+            size_t start = depth - depth % BLOCK;
+            block_max[depth / BLOCK] = *std::max_element(stack.begin() + start,
+                                                         stack.begin() + std::min(start + BLOCK, stack.size()));
+
+            // Entries below the largest capacity never matter again
+            if (stack.size() > max_depth) {
+                depth_of[stack.back()] = NOT_IN_STACK;
+                stack.pop_back();
+                if (stack.size() % BLOCK == 0) block_max.pop_back();
+            }
+        }
+    }
+
+public:
+    // Simulate the sequence for capacities up to max_capacity. A cache larger
+    // than the sequence behaves like one the size of the sequence, so the
+    // depth is clamped to it
+    OptStackAnalyzer(const std::vector<TraceRecord>& requests, size_t max_capacity)
+        : max_depth(std::min(max_capacity, requests.size())), read_histogram(max_depth, 0), write_histogram(max_depth, 0) {
+        analyze(requests, [&](size_t i) { return requests[i].type; });
+    }
+
+    OptStackAnalyzer(const TraceColumns& requests, size_t max_capacity)
+        : max_depth(std::min(max_capacity, requests.size())), read_histogram(max_depth, 0), write_histogram(max_depth, 0) {
+        analyze(requests.offsets, [&](size_t i) { return requests.types[i]; });
+    }
+
+    size_t getDistinctOffsets() const { return distinct; }
+
+    // Statistics of bypassing OPT caches holding each of `capacities` offsets,
+    // in the same order; capacities above max_capacity are clamped to it
+    std::vector<CacheStats> statsForCapacities(const std::vector<size_t>& capacities) const {
+        std::vector<CacheStats> result;
+        for (size_t capacity : capacities) {
+            size_t last = std::min(capacity, max_depth);
+            long long read_hits = 0, write_hits = 0;
+            for (size_t d = 0; d < last; d++) {
+                read_hits += read_histogram[d];
+                write_hits += write_histogram[d];
+            }
+            CacheStats stats;
+            stats.total_reads = reads;
+            stats.total_writes = writes;
+            stats.total_requests = reads + writes;
+            stats.total_read_hits = read_hits;
+            stats.total_write_hits = write_hits;
+            stats.total_hits = read_hits + write_hits;
+            stats.total_read_misses = reads - read_hits;
+            stats.total_write_misses = writes - write_hits;
+            stats.total_misses = stats.total_read_misses + stats.total_write_misses;
+            stats.cold_misses = static_cast<long long>(distinct);
+            result.push_back(stats);
+        }
+        return result;
+    }
+};
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <string>
+
+#include "../Common/TraceReader.h"
+#include "../Common/BinaryTrace.h"
+
+// Convert a CSV trace into the compact binary format read by all simulators
+int main() {
+    std::string input_file, output_file;
+
+    std::cout << "Enter CSV trace path: ";
+    std::cin >> input_file;
+    std::cout << "Enter binary output path: ";
+    std::cin >> output_file;
+
+    TraceReader reader(input_file);
+    if (!reader.isOpen()) {
+        std::cerr << "Error: Could not open file " << input_file << std::endl;
+        return 1;
+    }
+    if (reader.isBinary()) {
+        std::cerr << "Error: " << input_file << " is already a binary trace." << std::endl;
+        return 1;
+    }
+
+    BinaryTraceWriter writer;
+    if (!writer.open(output_file)) {
+        std::cerr << "Error: Could not create file " << output_file << std::endl;
+        return 1;
+    }
+
+    TraceRecord record;
+    long long total_requests = 0;
+    while (reader.next(record)) {
+        writer.write(record);
+        total_requests++;
+    }
+
+    uint64_t entries = writer.getEntryCount();
+    if (!writer.close()) {
+        std::cerr << "Error: Failed writing " << output_file << std::endl;
+        return 1;
+    }
+
+    std::cout << "Converted Requests: " << total_requests << std::endl;
+    std::cout << "Skipped Lines: " << reader.getSkippedLines() << std::endl;
+    std::cout << "Timestamp Escapes: " << (entries - static_cast<uint64_t>(total_requests)) << std::endl;
+    std::cout << "Output Size: " << (sizeof(BinaryTraceHeader) + entries * sizeof(BinaryTraceEntry)) << " bytes" << std::endl;
+    return 0;
+}
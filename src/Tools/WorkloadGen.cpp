@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "../Common/BinaryTrace.h"
+#include "../Common/Workload.h"
+
+// Write a generated workload (see Workload.h) to a trace file: CSV in the
+// layout of the recorded traces, or the binary format when the output name
+// ends in ".bin"
+int main() {
+    std::string workload, output_file;
+
+    std::cout << "Enter workload spec (gen:<pattern>[:key=value]...): ";
+    std::cin >> workload;
+    std::cout << "Enter output path: ";
+    std::cin >> output_file;
+
+    WorkloadSpec spec;
+    std::string error;
+    if (!parseWorkloadSpec(workload, spec, error)) {
+        std::cerr << "Error: Bad workload " << workload << ": " << error << std::endl;
+        return 1;
+    }
+
+    bool binary = output_file.size() >= 4 && output_file.compare(output_file.size() - 4, 4, ".bin") == 0;
+    WorkloadGenerator generator(spec);
+    TraceRecord record;
+
+    if (binary) {
+        BinaryTraceWriter writer;
+        if (!writer.open(output_file)) {
+            std::cerr << "Error: Could not create file " << output_file << std::endl;
+            return 1;
+        }
+        while (generator.next(record)) writer.write(record);
+        if (!writer.close()) {
+            std::cerr << "Error: Failed writing " << output_file << std::endl;
+            return 1;
+        }
+    } else {
+        FILE* out = fopen(output_file.c_str(), "w");
+        if (out == nullptr) {
+            std::cerr << "Error: Could not create file " << output_file << std::endl;
+            return 1;
+        }
+        static char buffer[1 << 20];
+        setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+        bool ok = true;
+        while (ok && generator.next(record)) {
+            ok = fprintf(out, "%lld,%u,%lld,%u,%s\n", record.timestamp, record.response_time, record.offset,
+                         record.size, record.type == OpType::Read ? "Read" : "Write") > 0;
+        }
+        if (fclose(out) != 0 || !ok) {
+            std::cerr << "Error: Failed writing " << output_file << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Generated Requests: " << generator.getProduced() << std::endl;
+    return 0;
+}